@@ -12,6 +12,7 @@ through this node.
 #include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/classes/viewport.hpp>
 #include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/time.hpp>
 #include <godot_cpp/classes/input_map.hpp>
 #include <godot_cpp/classes/input_event_key.hpp>
 #include <godot_cpp/classes/input_event_mouse_button.hpp>
@@ -54,12 +55,17 @@ void ControlsManager::_bind_methods()
     ClassDB::bind_method(D_METHOD("_gamepad_connected"), &ControlsManager::_gamepad_connected);
 
     // INPUT STATES
-    ClassDB::bind_method(D_METHOD("pressed", "action"), &ControlsManager::pressed);
-    ClassDB::bind_method(D_METHOD("released", "action"), &ControlsManager::released);
-    ClassDB::bind_method(D_METHOD("held", "action"), &ControlsManager::held);
-    ClassDB::bind_method(D_METHOD("get_held_time", "action"), &ControlsManager::get_held_time);
+    ClassDB::bind_method(D_METHOD("pressed", "action"), static_cast<bool (ControlsManager::*)(String)>(&ControlsManager::pressed));
+    ClassDB::bind_method(D_METHOD("released", "action"), static_cast<bool (ControlsManager::*)(String)>(&ControlsManager::released));
+    ClassDB::bind_method(D_METHOD("held", "action"), static_cast<bool (ControlsManager::*)(String)>(&ControlsManager::held));
+    ClassDB::bind_method(D_METHOD("get_held_time", "action"), static_cast<float (ControlsManager::*)(String)>(&ControlsManager::get_held_time));
     ClassDB::bind_method(D_METHOD("release_all"), &ControlsManager::release_all);
 
+    // EVENT HISTORY
+    ClassDB::bind_method(D_METHOD("pressed_since", "action", "tick"), static_cast<bool (ControlsManager::*)(String, int64_t)>(&ControlsManager::pressed_since));
+    ClassDB::bind_method(D_METHOD("released_since", "action", "tick"), static_cast<bool (ControlsManager::*)(String, int64_t)>(&ControlsManager::released_since));
+    ClassDB::bind_method(D_METHOD("consume_mouse_motion"), &ControlsManager::consume_mouse_motion);
+
     // LOCKOUT
     ClassDB::bind_method(D_METHOD("mouse_lock", "locked"), &ControlsManager::mouse_lock);
 
@@ -139,15 +145,15 @@ void ControlsManager::_gamepad_connected(int device_id, bool is_connected)
 }
 
 // Detect current input method; used for UI display mostly
-void ControlsManager::input_mode_swap(InputEvent* event)
+void ControlsManager::input_mode_swap(const EventInfo& ev)
 {
     if (input_mode == InputMode::Keyboard)
     {
         bool pad = false;
-        if (event->get_class() == "InputEventJoypadButton")
+        if (ev.type == InputType::JOYBUTTON)
             pad = true;
         // If we don't check the deadzone, it will always be putting out the JoypadMotion event
-        if (event->get_class() == "InputEventJoypadMotion" && abs(float(event->call("get_axis_value"))) > DEADZONE)
+        if (ev.type == InputType::JOYAXIS && Math::abs(ev.value) > DEADZONE)
             pad = true;
         if (pad)
         {
@@ -161,92 +167,134 @@ void ControlsManager::input_mode_swap(InputEvent* event)
             //set_control_map();
         };
     }
-    else if (event->get_class() == "InputEventKey" || event->get_class() == "InputEventMouseButton")
+    else if (ev.type == InputType::KEY || ev.type == InputType::MOUSEBUTTON)
         input_mode = InputMode::Keyboard;
 }
 
 /*************************************************
 MAPPING
 *************************************************/
-void ControlsManager::set_control_map()
+ControlsManager::ActionBinding* ControlsManager::control_map(int mode)
 {
-    InputMap* IM = InputMap::get_singleton();
-    String control;
-    int map_input[2]; // input
-    //int last_input = gamepad_control_map[control][1];
+    if (mode == InputMode::Keyboard)
+        return keyboard_control_map;
+    return gamepad_control_map;
+}
 
-    for (int i = 0; i < ACTIONS.size(); i++)
+// The event InputMap should hold for this binding; keyboard takes keys and mouse buttons, gamepad takes joypad input
+Ref<InputEvent> ControlsManager::binding_event(int slot, const ActionBinding& binding)
+{
+    // A binding in the wrong slot gets no event, whether or not the other slot has it cached
+    bool keyboard_type = binding.type == InputType::KEY || binding.type == InputType::MOUSEBUTTON;
+    bool gamepad_type = binding.type == InputType::JOYBUTTON || binding.type == InputType::JOYAXIS;
+    if (slot == InputMode::Keyboard ? !keyboard_type : !gamepad_type)
+        return Ref<InputEvent>();
+
+    int64_t key = binding_key(binding.type, binding.code);
+    Ref<InputEvent>* cached = binding_events.getptr(key);
+    if (cached != nullptr)
+        return *cached;
+
+    Ref<InputEvent> input_event;
+    if (slot == InputMode::Keyboard)
     {
-        control = ACTIONS[i];
-        IM->action_erase_events(control);
+        switch (binding.type)
+        {
+        case InputType::KEY:
+        {
+            Ref<InputEventKey> event;
+            event.instantiate();
+            event->set_keycode(Key(binding.code));
+            input_event = event;
+            break;
+        }
+        case InputType::MOUSEBUTTON:
+        {
+            Ref<InputEventMouseButton> event;
+            event.instantiate();
+            event->set_button_index(MouseButton(binding.code));
+            input_event = event;
+            break;
+        }
+        }
+    }
+    else
+    {
+        switch (binding.type)
+        {
+        case InputType::JOYBUTTON:
+        {
+            Ref<InputEventJoypadButton> event;
+            event.instantiate();
+            event->set_button_index(JoyButton(binding.code));
+            input_event = event;
+            break;
+        }
+        case InputType::JOYAXIS:
+        {
+            Ref<InputEventJoypadMotion> event;
+            event.instantiate();
+            event->set_axis(JoyAxis(binding.code));
+            input_event = event;
+            break;
+        }
+        }
+    };
+    binding_events.insert(key, input_event);
+    return input_event;
+}
 
-        for (int j = 0; j < 2; j++)
+// Bring InputMap in line with the live maps for one action, leaving it alone if nothing changed
+void ControlsManager::rebind_action(int action)
+{
+    InputMap* IM = InputMap::get_singleton();
+    for (int slot = 0; slot < 2; slot++)
+    {
+        const ActionBinding& binding = control_map(slot)[action];
+        ActionBinding& applied = applied_map[slot][action];
+        if (applied.type == binding.type && applied.code == binding.code && applied.deadzone == binding.deadzone)
+            continue;
+        Ref<InputEvent>& event = applied_events[slot][action];
+        if (event.is_valid())
+            IM->action_erase_event(action_names[action], event);
+        event = binding_event(slot, binding);
+        if (event.is_valid())
         {
-            if (j == InputMode::Keyboard)
-            {
-                map_input[0] = keyboard_control_map[control.utf8().get_data()][0]; // input event type
-                map_input[1] = keyboard_control_map[control.utf8().get_data()][1]; // input index
-                switch (map_input[0])
-                {
-                case InputType::KEY:
-                {
-                    Ref<InputEventKey> event;
-                    event.instantiate();
-                    event->set_keycode(Key(map_input[1]));
-                    IM->action_add_event(control, event);
-                    break;
-                }
-                case InputType::MOUSEBUTTON:
-                {
-                    Ref<InputEventMouseButton> event;
-                    event.instantiate();
-                    event->set_button_index(MouseButton(map_input[1]));
-                    /*
-                    while (mouse_actions.size() < map_input[1])
-                        mouse_actions.push_back("");
-                    mouse_actions[map_input[1]] = control;
-                    */
-                    IM->action_add_event(control, event);
-                    break;
-                }
-                }
-            }
-            else
-            {
-                map_input[0] = gamepad_control_map[control.utf8().get_data()][0]; // input event type
-                map_input[1] = gamepad_control_map[control.utf8().get_data()][1]; // input index
-                //if (i > 0)
-                //    last_input = gamepad_control_map[ACTIONS[i - 1]][1];
-                switch (map_input[0])
-                {
-                case InputType::JOYBUTTON:
-                {
-                    Ref<InputEventJoypadButton> event;
-                    event.instantiate();
-                    event->set_button_index(JoyButton(map_input[1]));
-                    IM->action_add_event(control, event);
-                    break;
-                }
-                case InputType::JOYAXIS:
-                {
-                    //if (control == "move_down" || control == "move_backward")
-                    //    map_input[1] = last_input;
-                    Ref<InputEventJoypadMotion> event;
-                    event.instantiate();
-                    event->set_axis(JoyAxis(map_input[1]));
-                    IM->action_add_event(control, event);
-                    IM->action_set_deadzone(control, DEADZONE);
-                }
-                }
-            };
+            IM->action_add_event(action_names[action], event);
+            if (binding.type == InputType::JOYAXIS)
+                IM->action_set_deadzone(action_names[action], binding.deadzone);
         };
+        applied = binding;
     };
 }
 
+void ControlsManager::set_control_map()
+{
+    for (int i = 0; i < ACTION_COUNT; i++)
+        rebind_action(i);
+}
+
+// Every ActionID bound to this input in either map; two small flat arrays are quicker to scan than anything hashed
+uint32_t ControlsManager::actions_for(int type, int code)
+{
+    uint32_t actions = 0;
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        if (keyboard_control_map[i].type == type && keyboard_control_map[i].code == code)
+            actions |= 1u << i;
+        if (gamepad_control_map[i].type == type && gamepad_control_map[i].code == code)
+            actions |= 1u << i;
+    };
+    return actions;
+}
+
 void ControlsManager::reset_to_defaults()
 {
-    keyboard_control_map = DEFAULT_KEYBOARD_MAP;
-    gamepad_control_map = DEFAULT_GAMEPAD_MAP;
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        keyboard_control_map[i] = DEFAULT_KEYBOARD_MAP[i];
+        gamepad_control_map[i] = DEFAULT_GAMEPAD_MAP[i];
+    };
     mouse_sensitivity = Vector2(0.5f, 0.5f);
     mouse_invert = Vector2(1.0f, 1.0f);
     gamepad_invert = Vector2(1.0f, 1.0f);
@@ -259,19 +307,17 @@ void ControlsManager::set_remap_mode(String new_remap_action, bool new_remap_mod
     remap_mode = new_remap_mode;
 }
 
-bool ControlsManager::remap(InputEvent* event, String action)
+bool ControlsManager::remap(const EventInfo& ev, String action)
 {
-    String _class = event->get_class();
-
     // We don't accept mouse motion because it's more work than I feel like putting in right now, maybe later
-    if (_class == "InputEventMouseMotion")
+    if (ev.type == InputType::MOUSEAXIS)
         return false;
 
     int new_input[2] = { -1, -1 }, input_check[2] = { -1, -1 };
 
-    if (_class == "InputEventKey")
+    if (ev.type == InputType::KEY)
     {
-        input_check[1] = event->call("get_keycode");
+        input_check[1] = ev.code;
         if (input_check[1] != KEY_QUOTELEFT)
             if (input_check[1] < KEY_F1 || input_check[1] > KEY_F12)
             {
@@ -279,16 +325,16 @@ bool ControlsManager::remap(InputEvent* event, String action)
                 new_input[1] = input_check[1];
             }
     }
-    else if (_class == "InputEventMouseButton")
+    else if (ev.type == InputType::MOUSEBUTTON)
     {
         new_input[0] = InputType::MOUSEBUTTON;
-        new_input[1] = event->call("get_button_index");
+        new_input[1] = ev.code;
         //while (new_input[1] >= mouse_actions.size())
         //    mouse_actions.push_back("");
     }
-    else if (_class == "InputEventJoypadMotion")
+    else if (ev.type == InputType::JOYAXIS)
     {
-        input_check[1] = event->call("get_axis");
+        input_check[1] = ev.code;
         // Joysticks are reserved for movement and aim, but the triggers are fair game
         if (input_check[1] > JOY_AXIS_RIGHT_Y)
         {
@@ -296,9 +342,9 @@ bool ControlsManager::remap(InputEvent* event, String action)
             new_input[1] = input_check[1];
         }
     }
-    else if (_class == "InputEventJoypadButton")
+    else if (ev.type == InputType::JOYBUTTON)
     {
-        input_check[1] = event->call("get_button_index");
+        input_check[1] = ev.code;
         if (input_check[1] != JOY_BUTTON_GUIDE && input_check[1] != JOY_BUTTON_MISC1)
         {
             new_input[0] = InputType::JOYBUTTON;
@@ -308,24 +354,23 @@ bool ControlsManager::remap(InputEvent* event, String action)
 
     if (new_input[1] >= 0)
     {
+        int id = action_id(action);
+        if (id < 0)
+        {
+            release_all();
+            return false;
+        };
         // Grab the right map
-        std::unordered_map<std::string, std::vector<int>> current_control_map;
-        if (input_mode == InputMode::Keyboard)
-            current_control_map = keyboard_control_map;
-        else
-            current_control_map = gamepad_control_map;
+        ActionBinding* current_control_map = control_map(input_mode);
 
-        std::string _action = action.utf8().get_data();
-
-        // We need to make sure we don't have 2 actions assigned to the same input
-        input_check[0] = current_control_map[_action][0];
-        input_check[1] = current_control_map[_action][1];
-        for (std::unordered_map<std::string, std::vector<int>>::iterator itr = current_control_map.begin(); itr != current_control_map.end(); itr++)
+        // We need to make sure we don't have 2 actions assigned to the same input; whoever had it gets our old one
+        int swapped = -1;
+        for (int i = 0; i < ACTION_COUNT; i++)
         {
-            if (itr->second[1] == new_input[1] && itr->second[0] == new_input[0])
+            if (current_control_map[i].code == new_input[1] && current_control_map[i].type == new_input[0])
             {
-                current_control_map[itr->first][0] = input_check[0];
-                current_control_map[itr->first][1] = input_check[1];
+                current_control_map[i] = current_control_map[id];
+                swapped = i;
                 break;
             }
         }
@@ -342,16 +387,13 @@ bool ControlsManager::remap(InputEvent* event, String action)
         */
         
         // Setting up the new control
-        current_control_map[_action][0] = new_input[0];
-        current_control_map[_action][1] = new_input[1];
-        // Return the modified map to the appropriate map
-        if (input_mode == InputMode::Keyboard)
-            keyboard_control_map = current_control_map;
-        else
-            gamepad_control_map = current_control_map;
+        current_control_map[id].type = new_input[0];
+        current_control_map[id].code = new_input[1];
         
-        // Remap Controls
-        set_control_map();
+        // Remap Controls; only the two actions that changed
+        rebind_action(id);
+        if (swapped >= 0)
+            rebind_action(swapped);
         //get_node("/root/SoundManager")->call("menu_confirm");
         release_all();
         return true;
@@ -362,51 +404,42 @@ bool ControlsManager::remap(InputEvent* event, String action)
     return false;
 }
 
+// Unknown action names are skipped; anything missing keeps its current binding
 void ControlsManager::dict_to_map(int mode, Dictionary new_map)
 {
-    std::unordered_map<std::string, std::vector<int>> control_map;
+    ActionBinding* current_control_map = control_map(mode);
     Array keys = new_map.keys(), v;
     for (int i = 0; i < keys.size(); i++)
     {
+        int id = action_id(keys[i]);
+        if (id < 0)
+            continue;
         v = new_map[keys[i]];
-        control_map[String(keys[i]).utf8().get_data()] = {v[0], v[1]};
+        current_control_map[id].type = v[0];
+        current_control_map[id].code = v[1];
     };
-    if (input_mode == InputMode::Keyboard)
-        keyboard_control_map = control_map;
-    else
-        gamepad_control_map = control_map;
 }
 
 Dictionary ControlsManager::map_to_dict(int mode)
 {
-    std::unordered_map<std::string, std::vector<int>> control_map;
-    if (input_mode == InputMode::Keyboard)
-        control_map = keyboard_control_map;
-    else
-        control_map = gamepad_control_map;
+    ActionBinding* current_control_map = control_map(mode);
     Dictionary dict_map = {};
-    for (std::unordered_map<std::string, std::vector<int>>::iterator itr = control_map.begin(); itr != control_map.end(); itr++)
-        dict_map[String(itr->first.c_str())] = Array::make(itr->second[0], itr->second[1]);
+    for (int i = 0; i < ACTION_COUNT; i++)
+        dict_map[ACTIONS[i]] = Array::make(current_control_map[i].type, current_control_map[i].code);
     return dict_map;
 }
 
 String ControlsManager::action_to_ui(String action, int mode)
 {
-    std::string _action = action.utf8().get_data();
+    int id = action_id(action);
+    if (id < 0)
+        return "";
 
     int ui_input[2] = { -1 };
     if (mode < 0)
         mode = input_mode;
-    if (mode == InputMode::Keyboard)
-    {
-        ui_input[0] = keyboard_control_map[_action][0];
-        ui_input[1] = keyboard_control_map[_action][1];
-    }
-    else
-    {
-        ui_input[0] = gamepad_control_map[_action][0];
-        ui_input[1] = gamepad_control_map[_action][1];
-    }
+    ui_input[0] = control_map(mode)[id].type;
+    ui_input[1] = control_map(mode)[id].code;
 
     if (ui_input[0] == InputType::KEY)
         return OS::get_singleton()->get_keycode_string(Key(ui_input[1]));
@@ -445,39 +478,182 @@ String ControlsManager::action_to_ui(String action, int mode)
     {
         return "";
     }
+    return "";
 }
 
 /*************************************************
 INPUT STATES
 *************************************************/
-bool ControlsManager::pressed(String action) { return (lockout <= 0.0f && INPUT->is_action_just_pressed(action)); }
+int ControlsManager::action_id(const String& action)
+{
+    const int* id = action_ids.getptr(StringName(action));
+    if (id == nullptr)
+        return -1;
+    return *id;
+}
+
+// Only transitions count; analog axes keep sending events either side of the deadzone
+void ControlsManager::set_action_state(int action, bool down)
+{
+    uint32_t bit = 1u << action;
+    if (((held_bits & bit) != 0) == down)
+        return;
+    Engine* engine = Engine::get_singleton();
+    ActionEdges* edges[2] = { &process_edges, &physics_edges };
+    uint64_t frames[2] = { engine->get_process_frames(), engine->get_physics_frames() };
+    for (int i = 0; i < 2; i++)
+    {
+        if (edges[i]->frame != frames[i])
+            *edges[i] = { frames[i], 0, 0 };
+        if (down)
+            edges[i]->pressed |= bit;
+        else
+            edges[i]->released |= bit;
+    };
+    if (down)
+        held_bits |= bit;
+    else
+        held_bits &= ~bit;
+    if (down)
+        record_event(bit, 0, Vector2());
+    else
+        record_event(0, bit, Vector2());
+}
 
-bool ControlsManager::released(String action) { return (lockout <= 0.0f && INPUT->is_action_just_released(action)); }
+ControlsManager::ActionEdges ControlsManager::frame_edges()
+{
+    Engine* engine = Engine::get_singleton();
+    if (engine->is_in_physics_frame())
+        return (physics_edges.frame == engine->get_physics_frames()) ? physics_edges : ActionEdges();
+    return (process_edges.frame == engine->get_process_frames()) ? process_edges : ActionEdges();
+}
+
+bool ControlsManager::pressed(int action) { return (lockout <= 0.0f && action >= 0 && action < ACTION_COUNT && (frame_edges().pressed >> action) & 1); }
+bool ControlsManager::pressed(String action) { return pressed(action_id(action)); }
 
-bool ControlsManager::held(String action) { return (lockout <= 0.0f && INPUT->is_action_pressed(action)); }
+bool ControlsManager::released(int action) { return (lockout <= 0.0f && action >= 0 && action < ACTION_COUNT && (frame_edges().released >> action) & 1); }
+bool ControlsManager::released(String action) { return released(action_id(action)); }
+
+bool ControlsManager::held(int action) { return (lockout <= 0.0f && action >= 0 && action < ACTION_COUNT && (held_bits >> action) & 1); }
+bool ControlsManager::held(String action) { return held(action_id(action)); }
+
+// Bindings carry no axis direction, which InputMap treats as the positive half of the axis
+void ControlsManager::update_action_states(const EventInfo& ev)
+{
+    uint32_t actions = actions_for(ev.type, ev.code);
+    if (actions == 0 || ev.echo)
+        return;
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        bool down = ev.pressed;
+        if (ev.type == InputType::JOYAXIS)
+            down = ev.value >= gamepad_control_map[i].deadzone;
+        if (((actions >> i) & 1) == 0 || ((held_bits >> i) & 1) == down)
+            continue;
+        set_action_state(i, down);
+        if (down)
+            emit_signal("action_pressed", ACTIONS[i]);
+        else
+            emit_signal("action_released", ACTIONS[i]);
+    };
+}
 
 void ControlsManager::update_held_time(float delta)
 {
-    std::string c;
-    for (int i = 0; i < ACTIONS.size(); i++)
+    for (int i = 0; i < ACTION_COUNT; i++)
     {
-        c = ACTIONS[i].utf8().get_data();
-        if (held(ACTIONS[i]))
-            held_time[c] = float(held_time[c]) + delta;
+        if (held(i))
+            held_time[i] += delta;
         else
-            held_time[c] = 0.0f;
+            held_time[i] = 0.0f;
+    };
+}
+
+float ControlsManager::get_held_time(int action)
+{
+    if (action < 0 || action >= ACTION_COUNT)
+        return 0.0f;
+    return held_time[action];
+}
+float ControlsManager::get_held_time(String action) { return get_held_time(action_id(action)); }
+
+/*************************************************
+EVENT HISTORY
+*************************************************/
+void ControlsManager::record_event(uint32_t pressed_bits, uint32_t released_bits, Vector2 motion)
+{
+    InputRecord rec;
+    rec.usec = Time::get_singleton()->get_ticks_usec();
+    rec.tick = Engine::get_singleton()->get_physics_frames();
+    rec.pressed = pressed_bits;
+    rec.released = released_bits;
+    rec.motion = motion;
+    // Only happens if nothing has drained for a good while (physics paused); count it rather than block
+    if (!event_ring.push(rec))
+        events_dropped++;
+}
+
+void ControlsManager::drain_events()
+{
+    InputRecord rec;
+    while (event_ring.pop(rec))
+    {
+        motion_accum += rec.motion;
+        for (int i = 0; i < ACTION_COUNT; i++)
+        {
+            if ((rec.pressed >> i) & 1)
+            {
+                press_tick[i] = rec.tick;
+                press_usec[i] = rec.usec;
+            };
+            if ((rec.released >> i) & 1)
+                release_tick[i] = rec.tick;
+        };
     };
 }
 
-float ControlsManager::get_held_time(String action)
+bool ControlsManager::pressed_since(int action, uint64_t tick)
+{
+    if (lockout > 0.0f || action < 0 || action >= ACTION_COUNT)
+        return false;
+    drain_events();
+    return press_tick[action] != UINT64_MAX && press_tick[action] >= tick;
+}
+bool ControlsManager::pressed_since(String action, int64_t tick) { return pressed_since(action_id(action), uint64_t(tick)); }
+
+bool ControlsManager::released_since(int action, uint64_t tick)
+{
+    if (lockout > 0.0f || action < 0 || action >= ACTION_COUNT)
+        return false;
+    drain_events();
+    return release_tick[action] != UINT64_MAX && release_tick[action] >= tick;
+}
+bool ControlsManager::released_since(String action, int64_t tick) { return released_since(action_id(action), uint64_t(tick)); }
+
+uint64_t ControlsManager::last_pressed_usec(int action)
+{
+    if (action < 0 || action >= ACTION_COUNT)
+        return UINT64_MAX;
+    drain_events();
+    return press_usec[action];
+}
+
+// Every bit of mouse motion since the last call, however many events or frames that spans
+Vector2 ControlsManager::consume_mouse_motion()
 {
-    return held_time[action.utf8().get_data()];
+    drain_events();
+    Vector2 motion = motion_accum;
+    motion_accum = Vector2();
+    return motion;
 }
 
 void ControlsManager::release_all()
 {
-    for (int i = 0; i < ACTIONS.size(); i++)
-        INPUT->action_release(ACTIONS[i]);
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        set_action_state(i, false);
+        INPUT->action_release(action_names[i]);
+    };
 }
 
 void ControlsManager::mouse_lock(bool locked)
@@ -494,8 +670,15 @@ BASE PROCESSING
 ControlsManager::ControlsManager()
 {
 	set_process_mode(Node::PROCESS_MODE_ALWAYS);
-    keyboard_control_map = DEFAULT_KEYBOARD_MAP;
-    gamepad_control_map = DEFAULT_GAMEPAD_MAP;
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        keyboard_control_map[i] = DEFAULT_KEYBOARD_MAP[i];
+        gamepad_control_map[i] = DEFAULT_GAMEPAD_MAP[i];
+        applied_map[0][i] = applied_map[1][i] = { -1, 0, 0.0f };
+        action_names[i] = StringName(ACTIONS[i]);
+        action_ids.insert(action_names[i], i);
+        press_tick[i] = release_tick[i] = press_usec[i] = UINT64_MAX;
+    };
 }
 
 ControlsManager::~ControlsManager() {}
@@ -508,8 +691,16 @@ void ControlsManager::ready()
     INPUT = Input::get_singleton();
     INPUT->connect("joy_connection_changed", Callable(this, "_gamepad_connected"));
     InputMap* inmap = InputMap::get_singleton();
-    for (int i = 0; i < ACTIONS.size(); i++)
-        inmap->add_action(ACTIONS[i]);
+    // Start from empty actions; from here on rebind_action keeps track of what's in them
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        if (!inmap->has_action(action_names[i]))
+            inmap->add_action(action_names[i]);
+        inmap->action_erase_events(action_names[i]);
+        applied_map[0][i] = applied_map[1][i] = { -1, 0, 0.0f };
+        applied_events[0][i].unref();
+        applied_events[1][i].unref();
+    };
     set_control_map();
     //mouse_lock(true);
 }
@@ -529,16 +720,66 @@ void ControlsManager::process(float delta)
     };
 }
 
+ControlsManager::EventInfo ControlsManager::classify_event(InputEvent* event)
+{
+    EventInfo ev;
+    // Most common first; a 1000 Hz mouse sends far more of these than anything else
+    if (InputEventMouseMotion* motion = Object::cast_to<InputEventMouseMotion>(event))
+    {
+        ev.type = InputType::MOUSEAXIS;
+        ev.relative = motion->get_relative();
+    }
+    else if (InputEventJoypadMotion* axis = Object::cast_to<InputEventJoypadMotion>(event))
+    {
+        ev.type = InputType::JOYAXIS;
+        ev.code = axis->get_axis();
+        ev.value = axis->get_axis_value();
+    }
+    else if (InputEventKey* key = Object::cast_to<InputEventKey>(event))
+    {
+        ev.type = InputType::KEY;
+        ev.code = key->get_keycode();
+        ev.pressed = key->is_pressed();
+        ev.echo = key->is_echo();
+    }
+    else if (InputEventMouseButton* button = Object::cast_to<InputEventMouseButton>(event))
+    {
+        ev.type = InputType::MOUSEBUTTON;
+        ev.code = button->get_button_index();
+        ev.pressed = button->is_pressed();
+    }
+    else if (InputEventJoypadButton* button = Object::cast_to<InputEventJoypadButton>(event))
+    {
+        ev.type = InputType::JOYBUTTON;
+        ev.code = button->get_button_index();
+        ev.pressed = button->is_pressed();
+    };
+    return ev;
+}
+
+// Keeps the ring near empty even when nobody asks for the history
+void ControlsManager::physics_process(float delta)
+{
+    if (Engine::get_singleton()->is_editor_hint())
+        return;
+
+    drain_events();
+}
+
 void ControlsManager::input(InputEvent* event)
 {
     if (Engine::get_singleton()->is_editor_hint())
         return;
 
+    EventInfo ev = classify_event(event);
+
     // Dev console eats inputs
     if (console_mode)
     {
-        if (event->get_class() == "InputEventKey")
+        if (ev.type == InputType::KEY)
             emit_signal("console_input", event);
+        // Nothing gets to see the matching releases while the console is up
+        release_all();
         get_viewport()->set_input_as_handled();
         return;
     };
@@ -546,7 +787,7 @@ void ControlsManager::input(InputEvent* event)
     // Input remapping eats inputs
     if (remap_mode)
     {
-        if (remap(event, remap_action))
+        if (remap(ev, remap_action))
         {
             remap_mode = false;
             emit_signal("action_remapped");
@@ -555,17 +796,24 @@ void ControlsManager::input(InputEvent* event)
         return;
     };
 
-    input_mode_swap(event);
+    input_mode_swap(ev);
 
     // Mouselook
-    if (event->get_class() == "InputEventMouseMotion" && input_mode == InputMode::Keyboard)
-        mouse_motion = Vector2(event->get("relative")) * mouse_sensitivity;
+    if (ev.type == InputType::MOUSEAXIS)
+    {
+        if (input_mode == InputMode::Keyboard)
+        {
+            mouse_motion = ev.relative * mouse_sensitivity;
+            record_event(0, 0, mouse_motion);
+        };
+        return;
+    };
     
     // Gamepad movement
-    else if (event->get_class() == "InputEventJoypadMotion" && input_mode != InputMode::Keyboard)
+    if (ev.type == InputType::JOYAXIS && input_mode != InputMode::Keyboard)
     {
-        int axis = event->get("axis");
-        float av = event->get("axis_value");
+        int axis = ev.code;
+        float av = ev.value;
         //av = (abs(av) - DEADZONE) / (1.0 - DEADZONE) * Math::sign(av);
         // Movement
         switch (axis)
@@ -607,19 +855,7 @@ void ControlsManager::input(InputEvent* event)
     };
     
     // Input states
-    for (int i = 0; i < ACTIONS.size(); i++)
-    {
-        if (event->is_action_pressed(ACTIONS[i]))
-        {
-            emit_signal("action_pressed", ACTIONS[i]);
-            break;
-        }
-        if (event->is_action_released(ACTIONS[i]))
-        {
-            emit_signal("action_released", ACTIONS[i]);
-            break;
-        };
-    };
+    update_action_states(ev);
 }
 
 void ControlsManager::_notification(int _notif) {
@@ -628,9 +864,13 @@ void ControlsManager::_notification(int _notif) {
     case NOTIFICATION_READY:
         ready();
         set_process(true);
+        set_physics_process(true);
         break;
     case NOTIFICATION_PROCESS:
         process(get_process_delta_time());
         break;
+    case NOTIFICATION_PHYSICS_PROCESS:
+        physics_process(get_physics_process_delta_time());
+        break;
     }
 }
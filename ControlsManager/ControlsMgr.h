@@ -4,18 +4,44 @@
 /********************************************************************************
 CONTROLS MANAGER
 ********************************************************************************/
-#include <string>
-#include <unordered_map>
 #include <godot_cpp/godot.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/classes/input.hpp>
 #include <godot_cpp/classes/input_event.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
 
 #define DEADZONE 0.333f
 
 namespace godot
 {
+    // Fixed ring of input between drains; input() and the physics step both run on the main thread,
+    // so it's plain counters, no locking. SIZE must be a power of two
+    template <class T, uint32_t SIZE>
+    class InputRing
+    {
+        static_assert((SIZE & (SIZE - 1)) == 0, "InputRing SIZE must be a power of two");
+        T items[SIZE];
+        uint32_t head = 0, tail = 0;
+    public:
+        bool push(const T& item)
+        {
+            if (head - tail >= SIZE)
+                return false;
+            items[head & (SIZE - 1)] = item;
+            head++;
+            return true;
+        }
+        bool pop(T& item)
+        {
+            if (tail == head)
+                return false;
+            item = items[tail & (SIZE - 1)];
+            tail++;
+            return true;
+        }
+    };
+
     class ControlsManager : public Node
     {
         GDCLASS(ControlsManager, Node)
@@ -26,7 +52,24 @@ namespace godot
 
         Input* INPUT = nullptr;
 
-        const std::vector<String> ACTIONS =
+        enum ActionID
+        {
+            ACTION_UP,
+            ACTION_DOWN,
+            ACTION_RIGHT,
+            ACTION_LEFT,
+            ACTION_ACCEPT,
+            ACTION_CANCEL,
+            ACTION_MENU,
+            ACTION_JUMP,
+            ACTION_SWITCH,
+            ACTION_TOOL,
+            ACTION_CONSOLE,
+            ACTION_COUNT
+        };
+
+        // Indexed by ActionID; C++ callers can skip the name lookup entirely
+        static constexpr const char* ACTIONS[ACTION_COUNT] =
         {
             "up",
             "down",
@@ -41,39 +84,91 @@ namespace godot
             "console"
         };
 
+        // Interned once in the constructor
+        StringName action_names[ACTION_COUNT];
+        HashMap<StringName, int> action_ids;
+
+        // Action state, one bit per ActionID, updated as events come in.
+        // Press/release edges are stamped with the frame they happened on, once for idle and once for physics,
+        // so pressed()/released() answer for whichever one the caller is running in
+        struct ActionEdges { uint64_t frame = UINT64_MAX; uint32_t pressed = 0, released = 0; };
+        ActionEdges process_edges, physics_edges;
+        uint32_t held_bits = 0;
+
+        // Raw input as it arrives, so nothing that happens between two ticks gets collapsed.
+        // input() produces; drain_events() consumes from the physics step, and the *_since queries drain first,
+        // so they belong on the physics side too
+        struct InputRecord
+        {
+            uint64_t usec = 0; // Time::get_ticks_usec() when it came in
+            uint64_t tick = 0; // physics frame it came in on
+            uint32_t pressed = 0, released = 0; // ActionID bits that changed
+            Vector2 motion; // mouse motion, sensitivity applied
+        };
+        InputRing<InputRecord, 1024> event_ring;
+        uint64_t events_dropped = 0;
+        // Consumer side; UINT64_MAX means never
+        Vector2 motion_accum;
+        uint64_t press_tick[ACTION_COUNT], release_tick[ACTION_COUNT], press_usec[ACTION_COUNT];
+
         enum InputType { KEY, MOUSEBUTTON, MOUSEAXIS, JOYBUTTON, JOYAXIS };
 
-        const std::unordered_map<std::string, std::vector<int>> DEFAULT_KEYBOARD_MAP =
+        // Everything input() needs from an event, read once through a single cast
+        struct EventInfo
+        {
+            int type = -1; // InputType, -1 for events we don't handle
+            int code = 0; // keycode, button index or axis
+            float value = 0.0f; // axis value
+            bool pressed = false, echo = false;
+            Vector2 relative; // mouse motion
+        };
+
+        struct ActionBinding
+        {
+            int type; // InputType
+            int code; // keycode, button index or axis
+            float deadzone;
+        };
+
+        // Indexed by ActionID
+        static constexpr ActionBinding DEFAULT_KEYBOARD_MAP[ACTION_COUNT] =
         {
-            {"up", { KEY, KEY_W }},
-            {"down", { KEY, KEY_S }},
-            {"right", { KEY, KEY_D }},
-            {"left", { KEY, KEY_A }},
-            {"accept", { KEY, KEY_E }},
-            {"cancel", { KEY, KEY_SHIFT }},
-            {"jump", { KEY, KEY_SPACE }},
-            {"switch", { KEY, KEY_R }},
-            {"tool", { KEY, KEY_F }},
-            {"menu", { KEY, KEY_Q }},
-            {"console", { KEY, KEY_QUOTELEFT }}
+            { KEY, KEY_W, DEADZONE }, // up
+            { KEY, KEY_S, DEADZONE }, // down
+            { KEY, KEY_D, DEADZONE }, // right
+            { KEY, KEY_A, DEADZONE }, // left
+            { KEY, KEY_E, DEADZONE }, // accept
+            { KEY, KEY_SHIFT, DEADZONE }, // cancel
+            { KEY, KEY_Q, DEADZONE }, // menu
+            { KEY, KEY_SPACE, DEADZONE }, // jump
+            { KEY, KEY_R, DEADZONE }, // switch
+            { KEY, KEY_F, DEADZONE }, // tool
+            { KEY, KEY_QUOTELEFT, DEADZONE } // console
         };
 
-        const std::unordered_map<std::string, std::vector<int>> DEFAULT_GAMEPAD_MAP =
+        static constexpr ActionBinding DEFAULT_GAMEPAD_MAP[ACTION_COUNT] =
         {
-            {"up", { JOYAXIS, JOY_AXIS_LEFT_Y }},
-            {"down", { JOYAXIS, JOY_AXIS_LEFT_Y }},
-            {"right", { JOYAXIS, JOY_AXIS_LEFT_X }},
-            {"left", { JOYAXIS, JOY_AXIS_LEFT_X }},
-            {"accept", { JOYBUTTON, JOY_BUTTON_B }},
-            {"cancel", { JOYBUTTON, JOY_BUTTON_A }},
-            {"jump", { JOYBUTTON, JOY_BUTTON_Y }},
-            {"switch", { JOYAXIS, JOY_AXIS_TRIGGER_LEFT }},
-            {"tool", { JOYBUTTON, JOY_BUTTON_LEFT_STICK }},
-            {"menu", { JOYBUTTON, JOY_BUTTON_BACK }},
-            {"console", { KEY, KEY_QUOTELEFT }}
+            { JOYAXIS, JOY_AXIS_LEFT_Y, DEADZONE }, // up
+            { JOYAXIS, JOY_AXIS_LEFT_Y, DEADZONE }, // down
+            { JOYAXIS, JOY_AXIS_LEFT_X, DEADZONE }, // right
+            { JOYAXIS, JOY_AXIS_LEFT_X, DEADZONE }, // left
+            { JOYBUTTON, JOY_BUTTON_B, DEADZONE }, // accept
+            { JOYBUTTON, JOY_BUTTON_A, DEADZONE }, // cancel
+            { JOYBUTTON, JOY_BUTTON_BACK, DEADZONE }, // menu
+            { JOYBUTTON, JOY_BUTTON_Y, DEADZONE }, // jump
+            { JOYAXIS, JOY_AXIS_TRIGGER_LEFT, DEADZONE }, // switch
+            { JOYBUTTON, JOY_BUTTON_LEFT_STICK, DEADZONE }, // tool
+            { KEY, KEY_QUOTELEFT, DEADZONE } // console
         };
 
-        std::unordered_map<std::string, std::vector<int>> keyboard_control_map = {}, gamepad_control_map = {};
+        // Live maps; remapping swaps entries in place
+        ActionBinding keyboard_control_map[ACTION_COUNT], gamepad_control_map[ACTION_COUNT];
+        // What InputMap holds right now per action, [0] keyboard and [1] gamepad; rebinding only touches what differs
+        ActionBinding applied_map[2][ACTION_COUNT];
+        Ref<InputEvent> applied_events[2][ACTION_COUNT];
+        // One event per binding ever used, so switching back to a binding doesn't build a new one
+        HashMap<int64_t, Ref<InputEvent>> binding_events;
+        static int64_t binding_key(int type, int code) { return (int64_t(type) << 32) | uint32_t(code); }
         //std::vector<String> mouse_actions = { "", "attack", "alt_attack", "", "", "", "", "", "" };
 
         Dictionary map = {};
@@ -87,20 +182,7 @@ namespace godot
         Vector2 mouse_motion = Vector2();
         Vector2 mouse_sensitivity = Vector2(0.5f, 0.5f);
         Vector2 move_motion = Vector2();
-        std::unordered_map<std::string, float> held_time =
-        {
-            {"up", 0.0f },
-            {"down", 0.0f },
-            {"right", 0.0f },
-            {"left", 0.0f },
-            {"accept", 0.0f },
-            {"cancel", 0.0f },
-            {"jump", 0.0f },
-            {"switch", 0.0f },
-            {"tool", 0.0f },
-            {"menu", 0.0f },
-            {"console", 0.0f }
-        };
+        float held_time[ACTION_COUNT] = {};
 
         ControlsManager();
         ~ControlsManager();
@@ -114,23 +196,39 @@ namespace godot
 
         // INPUT MODE DETECTION
         void _gamepad_connected(int device_id, bool is_connected);
-        void input_mode_swap(InputEvent* event);
+        void input_mode_swap(const EventInfo& ev);
 
         // MAPPING
+        ActionBinding* control_map(int mode);
+        Ref<InputEvent> binding_event(int slot, const ActionBinding& binding);
+        void rebind_action(int action);
         void set_control_map();
+        uint32_t actions_for(int type, int code);
         void reset_to_defaults();
         void set_remap_mode(String new_remap_action, bool new_remap_mode = true);
-        bool remap(InputEvent* event, String action);
+        bool remap(const EventInfo& ev, String action);
         void dict_to_map(int mode, Dictionary new_map);
         Dictionary map_to_dict(int mode);
         String action_to_ui(String action, int mode = -1);
 
         // INPUT STATES
-        bool pressed(String action);
-        bool released(String action);
-        bool held(String action);
+        int action_id(const String& action);
+        void set_action_state(int action, bool down);
+        ActionEdges frame_edges();
+        bool pressed(String action); bool pressed(int action);
+        bool released(String action); bool released(int action);
+        bool held(String action); bool held(int action);
+        void update_action_states(const EventInfo& ev);
         void update_held_time(float delta);
-        float get_held_time(String action);
+        float get_held_time(String action); float get_held_time(int action);
+
+        // EVENT HISTORY
+        void record_event(uint32_t pressed_bits, uint32_t released_bits, Vector2 motion);
+        void drain_events();
+        bool pressed_since(String action, int64_t tick); bool pressed_since(int action, uint64_t tick);
+        bool released_since(String action, int64_t tick); bool released_since(int action, uint64_t tick);
+        uint64_t last_pressed_usec(int action);
+        Vector2 consume_mouse_motion();
 
         // LOCKOUT
         void release_all();
@@ -139,6 +237,8 @@ namespace godot
         // BASE PROCESSING
         void ready();
         void process(float delta);
+        void physics_process(float delta);
+        EventInfo classify_event(InputEvent* event);
         void input(InputEvent* event);
         void _notification(int _notif);
     };
@@ -8,15 +8,46 @@ void MusicManager::_register_methods()
 	register_method("music_play", &MusicManager::music_play);
 	register_method("music_pause", &MusicManager::music_pause);
 	register_method("music_resume", &MusicManager::music_resume);
+	register_method("music_preload", &MusicManager::music_preload);
+	register_method("get_load_stats", &MusicManager::get_load_stats);
+	register_method("rebuild_song_index", &MusicManager::rebuild_song_index);
 	register_method("change_volume", &MusicManager::change_volume);
+	register_method("set_intensity", &MusicManager::set_intensity);
+	register_method("get_intensity", &MusicManager::get_intensity);
 	register_method("data_save", &MusicManager::data_save);
 	register_method("data_load", &MusicManager::data_load);
 	register_method("_process", &MusicManager::_process);
+	register_property<MusicManager, int>("fade_curve", &MusicManager::fade_curve, FADE_LINEAR);
 }
 
+// musicdb .json files get compiled into a binary index the first time they're seen; from then on startup is a
+// directory listing and one read, until one of them changes
 void MusicManager::build_song_defs()
 {
-	for (int d = 0; d < 2; d++)
+	Dictionary sources = scan_song_sources();
+	if (!read_song_index(SONG_INDEX_RES, sources) && !read_song_index(SONG_INDEX_USER, sources))
+	{
+		parse_song_sources(sources);
+		write_song_index(sources);
+	};
+}
+
+// Build step; called from a tool script in the editor before export, it writes the res:// index that ships prebuilt
+void MusicManager::rebuild_song_index()
+{
+	Dictionary sources = scan_song_sources();
+	parse_song_sources(sources);
+	write_song_index(sources);
+}
+
+// Every .json in res://music then user://music, in the order they override each other, with modified times.
+// The editor only looks in res://, so the index it builds for export doesn't pick up the developer's own mods
+Dictionary MusicManager::scan_song_sources()
+{
+	Dictionary sources;
+	Ref<File> file = Ref<File>(File::_new());
+	int dirs = Engine::get_singleton()->is_editor_hint() ? 1 : 2;
+	for (int d = 0; d < dirs; d++)
 	{
 		Ref<Directory> dir = Ref<Directory>(Directory::_new());
 		Error dir_chk;
@@ -32,27 +63,8 @@ void MusicManager::build_song_defs()
 			{
 				if (filename.rfind(".json") > -1)
 				{
-					Ref<File> file = Ref<File>(File::_new());
-					if (file->open(dir->get_current_dir() + "/" + filename, File::READ) == Error::OK)
-					{
-						Array song_data = (Array)JSON::get_singleton()->parse(file->get_as_text())->get_result();
-						for (int i = 0; i < song_data.size(); i++)
-						{
-							Dictionary data = song_data[i];
-							song_struct song;
-							song.id = data["id"];
-							song.name = data["name"];
-							song.file = data["file"];
-							Array loop_arr = data["loops"];
-							for (int j = 0; j < loop_arr.size(); j++)
-							{
-								Array l2 = loop_arr[j];
-								song.loops.push_back({ (float)l2[0],(float)l2[1] });
-							};
-							song_defs[song.id.alloc_c_string()] = song;
-						};
-						file->close();
-					};
+					String path = dir->get_current_dir() + "/" + filename;
+					sources[path] = file->get_modified_time(path);
 				};
 				filename = dir->get_next();
 			};
@@ -60,20 +72,341 @@ void MusicManager::build_song_defs()
 		else if (d > 0)
 			dir->make_dir("user://music");
 	};
+	return sources;
 }
 
-void MusicManager::load_song(std::string song_id)
+void MusicManager::parse_song_sources(const Dictionary& sources)
 {
-	if (song_defs.find(song_id) == song_defs.end())
+	songs.clear();
+	song_index.clear();
+	Array paths = sources.keys();
+	Ref<File> file = Ref<File>(File::_new());
+	for (int p = 0; p < paths.size(); p++)
 	{
-		stop();
+		if (file->open(paths[p], File::READ) == Error::OK)
+		{
+			Array song_data = (Array)JSON::get_singleton()->parse(file->get_as_text())->get_result();
+			for (int i = 0; i < song_data.size(); i++)
+			{
+				Dictionary data = song_data[i];
+				song_struct song;
+				song.id = data["id"];
+				song.name = data["name"];
+				song.file = data["file"];
+				Array loop_arr = data["loops"];
+				for (int j = 0; j < loop_arr.size(); j++)
+				{
+					Array l2 = loop_arr[j];
+					song.loops.push_back({ (float)l2[0],(float)l2[1] });
+				};
+				Array layer_arr = data["layers"];
+				for (int j = 0; j < layer_arr.size(); j++)
+				{
+					Dictionary l2 = layer_arr[j];
+					song.layers.push_back({ l2["name"], l2["file"], (float)l2["from"], (float)l2["to"] });
+				};
+				add_song(song);
+			};
+			file->close();
+		};
+	};
+}
+
+// Later definitions of an id replace earlier ones in place, so ids keep their slot
+void MusicManager::add_song(const song_struct& song)
+{
+	if (song_index.has(song.id))
+		songs[(int)song_index[song.id]] = song;
+	else
+	{
+		song_index[song.id] = int(songs.size());
+		songs.push_back(song);
+	};
+}
+
+int MusicManager::find_song(const String& song_id)
+{
+	if (!song_index.has(song_id))
+		return -1;
+	return song_index[song_id];
+}
+
+// Magic, version, then one Array: [sources, ids, names, files, first loop value per song, loop values,
+// first layer per song, layer names, layer files, layer from/to pairs]
+void MusicManager::write_song_index(const Dictionary& sources)
+{
+	PoolStringArray ids, names, files;
+	PoolStringArray layer_names, layer_files;
+	PoolIntArray loop_start, layer_start;
+	PoolRealArray loops, layer_ranges;
+	for (int i = 0; i < songs.size(); i++)
+	{
+		ids.append(songs[i].id);
+		names.append(songs[i].name);
+		files.append(songs[i].file);
+		loop_start.append(loops.size());
+		for (int j = 0; j < songs[i].loops.size(); j++)
+		{
+			loops.append(songs[i].loops[j][0]);
+			loops.append(songs[i].loops[j][1]);
+		};
+		layer_start.append(layer_names.size());
+		for (int j = 0; j < songs[i].layers.size(); j++)
+		{
+			const layer_struct& layer = songs[i].layers[j];
+			layer_names.append(layer.name);
+			layer_files.append(layer.file);
+			layer_ranges.append(layer.from);
+			layer_ranges.append(layer.to);
+		};
+	};
+	String path = Engine::get_singleton()->is_editor_hint() ? SONG_INDEX_RES : SONG_INDEX_USER;
+	Ref<File> file = Ref<File>(File::_new());
+	if (file->open(path, File::WRITE) != Error::OK)
 		return;
+	file->store_32(SONG_INDEX_MAGIC);
+	file->store_32(SONG_INDEX_VERSION);
+	file->store_var(Array::make(sources, ids, names, files, loop_start, loops, layer_start, layer_names, layer_files, layer_ranges));
+	file->close();
+}
+
+// Only trusted if it was built from exactly these files at exactly these modified times. Files packed into an
+// export have no modified time, so those are taken on trust
+bool MusicManager::read_song_index(const String& path, const Dictionary& sources)
+{
+	Ref<File> file = Ref<File>(File::_new());
+	if (file->open(path, File::READ) != Error::OK)
+		return false;
+	if (file->get_len() < 8 || file->get_32() != SONG_INDEX_MAGIC || file->get_32() != SONG_INDEX_VERSION)
+	{
+		file->close();
+		return false;
+	};
+	Array index = file->get_var();
+	file->close();
+	if (index.size() < 10)
+		return false;
+	Dictionary built_from = index[0];
+	Array paths = sources.keys();
+	if (built_from.size() != paths.size())
+		return false;
+	for (int p = 0; p < paths.size(); p++)
+	{
+		int64_t modified = sources[paths[p]];
+		if (!built_from.has(paths[p]) || (modified != 0 && (int64_t)built_from[paths[p]] != modified))
+			return false;
 	};
-	current_song = song_defs[song_id];
-	Ref<AudioStream> s = ResourceLoader::get_singleton()->load(current_song.file);
+	PoolStringArray ids = index[1], names = index[2], files = index[3];
+	PoolIntArray loop_start = index[4];
+	PoolRealArray loops = index[5];
+	PoolIntArray layer_start = index[6];
+	PoolStringArray layer_names = index[7], layer_files = index[8];
+	PoolRealArray layer_ranges = index[9];
+	songs.clear();
+	song_index.clear();
+	songs.resize(ids.size());
+	for (int i = 0; i < ids.size(); i++)
+	{
+		song_struct& song = songs[i];
+		song.id = ids[i];
+		song.name = names[i];
+		song.file = files[i];
+		int end = (i + 1 < ids.size()) ? loop_start[i + 1] : loops.size();
+		for (int j = loop_start[i]; j + 1 < end; j += 2)
+			song.loops.push_back({ loops[j], loops[j + 1] });
+		end = (i + 1 < ids.size()) ? layer_start[i + 1] : layer_names.size();
+		for (int j = layer_start[i]; j < end; j++)
+			song.layers.push_back({ layer_names[j], layer_files[j], layer_ranges[j * 2], layer_ranges[j * 2 + 1] });
+		song_index[song.id] = i;
+	};
+	return true;
+}
+
+void MusicManager::load_song(int song)
+{
+	if (song < 0 || song >= songs.size())
+	{
+		stems_stop();
+		return;
+	};
+	stems_stop();
+	restore_native_loops();
+	current_song = songs[song];
+	// Normally already loaded by the time we get here; a failed background load gets one more try
+	Ref<AudioStream> s = loader.get(current_song.file);
+	if (s.is_null())
+		s = ResourceLoader::get_singleton()->load(current_song.file);
 	set_stream(s);
+	// Layers start out at whatever the current intensity calls for
+	int layer_count = current_song.layers.size();
+	while (stems.size() < layer_count)
+	{
+		AudioStreamPlayer* stem = AudioStreamPlayer::_new();
+		stem->set_pause_mode(PAUSE_MODE_PROCESS);
+		stem->set_bus(get_bus());
+		add_child(stem);
+		stems.push_back(stem);
+	};
+	layer_gain.resize(layer_count);
+	layer_fades.resize(layer_count);
+	for (int i = 0; i < stems.size(); i++)
+	{
+		if (i >= layer_count)
+		{
+			stems[i]->set_stream(Ref<AudioStream>());
+			continue;
+		};
+		Ref<AudioStream> ls = loader.get(current_song.layers[i].file);
+		if (ls.is_null())
+			ls = ResourceLoader::get_singleton()->load(current_song.layers[i].file);
+		stems[i]->set_stream(ls);
+	};
+	set_intensity(intensity, 0.0f);
+	update_layers(fade_clock());
 	last_loop_index = 0;
-	seek(0.0f);
+	stems_seek(0.0f);
+}
+
+bool MusicManager::song_loading(int song)
+{
+	if (loader.is_pending(songs[song].file))
+		return true;
+	for (int i = 0; i < songs[song].layers.size(); i++)
+		if (loader.is_pending(songs[song].layers[i].file))
+			return true;
+	return false;
+}
+
+// Stems follow this player; transport changes go in under the audio server lock so every stem picks them up in
+// the same mix, which keeps them on the same sample
+void MusicManager::stems_play(float from)
+{
+	AudioServer::get_singleton()->lock();
+	play(from);
+	for (int i = 0; i < current_song.layers.size(); i++)
+		stems[i]->play(from);
+	AudioServer::get_singleton()->unlock();
+}
+
+void MusicManager::stems_seek(float to)
+{
+	AudioServer::get_singleton()->lock();
+	seek(to);
+	for (int i = 0; i < current_song.layers.size(); i++)
+		stems[i]->seek(to);
+	AudioServer::get_singleton()->unlock();
+}
+
+void MusicManager::stems_pause(bool paused)
+{
+	AudioServer::get_singleton()->lock();
+	set_stream_paused(paused);
+	for (int i = 0; i < current_song.layers.size(); i++)
+		stems[i]->set_stream_paused(paused);
+	AudioServer::get_singleton()->unlock();
+}
+
+void MusicManager::stems_stop()
+{
+	stop();
+	for (int i = 0; i < stems.size(); i++)
+		stems[i]->stop();
+}
+
+static float layer_gain_for(float from, float to, float intensity)
+{
+	if (to <= from)
+		return (intensity >= from) ? 1.0f : 0.0f;
+	return fminf(fmaxf((intensity - from) / (to - from), 0.0f), 1.0f);
+}
+
+// Each layer fades toward its gain for the new intensity over delay seconds, on the same envelopes change_volume uses
+void MusicManager::set_intensity(float new_intensity, float delay)
+{
+	intensity = new_intensity;
+	double now = fade_clock();
+	for (int i = 0; i < current_song.layers.size(); i++)
+	{
+		float target = layer_gain_for(current_song.layers[i].from, current_song.layers[i].to, intensity);
+		layer_fades[i] = { layer_gain[i], target, fmaxf(delay, 0.0f), now, fade_curve };
+		if (delay <= 0.0f)
+			layer_gain[i] = target;
+	};
+}
+
+float MusicManager::get_intensity() { return intensity; }
+
+// Stem volume is the music volume times the layer's own gain
+void MusicManager::update_layers(double now)
+{
+	for (int i = 0; i < current_song.layers.size(); i++)
+	{
+		layer_gain[i] = layer_fades[i].value(now);
+		stems[i]->set_volume_db(Math::linear2db(volume_current * layer_gain[i]));
+	};
+}
+
+float MusicManager::fade_struct::value(double now) const
+{
+	if (length <= 0.0f || now >= start + length)
+		return to;
+	float t = fmaxf(float((now - start) / length), 0.0f);
+	switch (curve)
+	{
+	// Power (gain squared) moves in a straight line, so a crossfade doesn't dip in the middle
+	case FADE_EQUAL_POWER:
+		return sqrtf(from * from * (1.0f - t) + to * to * t);
+	// Straight line in dB; silence stands in for -60 dB until the very end
+	case FADE_EXPONENTIAL:
+	{
+		float a = fmaxf(from, 0.001f), b = fmaxf(to, 0.001f);
+		return a * powf(b / a, t);
+	}
+	default:
+		return from + (to - from) * t;
+	};
+}
+
+// When the mix about to be heard starts; fades are evaluated there rather than at whenever the frame happened to run
+double MusicManager::fade_clock()
+{
+	return OS::get_singleton()->get_ticks_usec() / 1000000.0 + AudioServer::get_singleton()->get_time_to_next_mix();
+}
+
+// Hand the song to the loader; whatever's playing carries on until it's ready
+void MusicManager::queue_song(String song_id, int loop_id, float position, float vol_target, float delay)
+{
+	pending.id = song_id;
+	pending.song = find_song(song_id);
+	pending.loop = loop_id;
+	pending.position = position;
+	pending.volume = vol_target;
+	pending.delay = delay;
+	pending.active = true;
+	loader.request(songs[pending.song].file);
+	for (int i = 0; i < songs[pending.song].layers.size(); i++)
+		loader.request(songs[pending.song].layers[i].file);
+	if (!song_loading(pending.song))
+		start_pending(false);
+}
+
+// If we had to wait, the song fades in from silence rather than cutting in
+void MusicManager::start_pending(bool waited)
+{
+	pending.active = false;
+	load_song(pending.song);
+	play_loop(pending.loop);
+	if (pending.position >= 0.0f)
+		stems_seek(pending.position);
+	if (pending.volume >= 0.0f)
+	{
+		if (waited && pending.delay > 0.0f)
+		{
+			volume_current = 0.0f;
+			set_volume_db(Math::linear2db(0.0f));
+		};
+		change_volume(pending.volume, pending.delay);
+	};
 }
 
 void MusicManager::play_loop(int loop_id)
@@ -98,10 +431,95 @@ void MusicManager::play_loop(int loop_id)
 		current_loop_index = 0;
 		keep_looping = false;
 	};
+	apply_native_loop();
 	// Play it again, Sam
-	set_stream_paused(false);
+	stems_pause(false);
 	if (!is_playing())
-		play();
+		stems_play(0.0f);
+}
+
+// Where the format can loop by itself, hand it the loop points so the mixer wraps on the exact frame with
+// no seek; WAVs take any loop, Vorbis only one that runs to the end of the file. Anything else is polled in _process
+// (see readme.md for which musicdb entries that leaves). Stems have to wrap together, so if any of them can't do it
+// natively none of them do
+void MusicManager::apply_native_loop()
+{
+	restore_native_loops();
+	native_loop = false;
+	if (!keep_looping || current_loop[1] <= current_loop[0])
+		return;
+	if (!native_loop_supported(get_stream()))
+		return;
+	for (int i = 0; i < current_song.layers.size(); i++)
+		if (!native_loop_supported(stems[i]->get_stream()))
+			return;
+	// The streams may already be mixing; change them between mixes
+	AudioServer::get_singleton()->lock();
+	native_loop_stream(get_stream());
+	for (int i = 0; i < current_song.layers.size(); i++)
+		native_loop_stream(stems[i]->get_stream());
+	AudioServer::get_singleton()->unlock();
+	native_loop = true;
+}
+
+bool MusicManager::native_loop_supported(Ref<AudioStream> s)
+{
+	if (s.is_null())
+		return false;
+	if (Object::cast_to<AudioStreamSample>(s.ptr()) != nullptr)
+		return true;
+	if (AudioStreamOGGVorbis* ogg = Object::cast_to<AudioStreamOGGVorbis>(s.ptr()))
+		return current_loop[1] >= ogg->get_length() - 0.05f;
+	return false;
+}
+
+// Streams come out of the resource cache shared, so note how they were imported before changing anything
+void MusicManager::native_loop_stream(Ref<AudioStream> s)
+{
+	loop_backup backup = { s, false, 0.0f, 0, 0, 0 };
+	if (AudioStreamSample* wav = Object::cast_to<AudioStreamSample>(s.ptr()))
+	{
+		backup.mode = wav->get_loop_mode();
+		backup.begin = wav->get_loop_begin();
+		backup.end = wav->get_loop_end();
+		loop_backups.push_back(backup);
+		float rate = wav->get_mix_rate();
+		wav->set_loop_begin(int(roundf(current_loop[0] * rate)));
+		wav->set_loop_end(int(roundf(current_loop[1] * rate)));
+		wav->set_loop_mode(AudioStreamSample::LOOP_FORWARD);
+	}
+	else if (AudioStreamOGGVorbis* ogg = Object::cast_to<AudioStreamOGGVorbis>(s.ptr()))
+	{
+		backup.loop = ogg->has_loop();
+		backup.offset = ogg->get_loop_offset();
+		loop_backups.push_back(backup);
+		ogg->set_loop(true);
+		ogg->set_loop_offset(current_loop[0]);
+	};
+}
+
+void MusicManager::restore_native_loops()
+{
+	if (loop_backups.empty())
+		return;
+	AudioServer::get_singleton()->lock();
+	for (int i = 0; i < loop_backups.size(); i++)
+	{
+		const loop_backup& b = loop_backups[i];
+		if (AudioStreamSample* wav = Object::cast_to<AudioStreamSample>(b.stream.ptr()))
+		{
+			wav->set_loop_mode(AudioStreamSample::LoopMode(b.mode));
+			wav->set_loop_begin(b.begin);
+			wav->set_loop_end(b.end);
+		}
+		else if (AudioStreamOGGVorbis* ogg = Object::cast_to<AudioStreamOGGVorbis>(b.stream.ptr()))
+		{
+			ogg->set_loop(b.loop);
+			ogg->set_loop_offset(b.offset);
+		};
+	};
+	AudioServer::get_singleton()->unlock();
+	loop_backups.clear();
 }
 
 // Pause / Resume; when we pause, we save the current position so that we can pick up where we left off
@@ -112,7 +530,7 @@ void MusicManager::pause_loop()
 	if (!get_stream_paused())
 	{
 		saved_loop = Array::make(current_song.id, current_loop_index, get_playback_position());
-		set_stream_paused(true);
+		stems_pause(true);
 	};
 }
 
@@ -123,16 +541,29 @@ void MusicManager::resume_loop()
 		if (saved_loop.size() < 3)
 			saved_loop = Array::make(current_song.id, current_loop_index, get_playback_position());
 		String id = saved_loop[0];
-		load_song(id.alloc_c_string());
-		play_loop(saved_loop[1]);
-		seek(saved_loop[2]);
+		if (find_song(id) < 0)
+		{
+			stems_stop();
+			return;
+		};
+		queue_song(id, saved_loop[1], saved_loop[2], -1.0f, 0.0f);
 	};
 }
 
 // Allow the song to finish
-void MusicManager::exit_loop() { keep_looping = false; }
+void MusicManager::exit_loop()
+{
+	keep_looping = false;
+	apply_native_loop();
+}
 
-String MusicManager::get_song_name(String song_id) { return current_song.name; }
+String MusicManager::get_song_name(String song_id)
+{
+	int song = find_song(song_id);
+	if (song < 0)
+		return "";
+	return songs[song].name;
+}
 
 int MusicManager::get_current_loop() { return current_loop_index; }
 
@@ -150,31 +581,30 @@ bool MusicManager::is_loop_playing(int loop_id)
 	return false;
 }
 
-// Volume adjustment; instantly change if time is negative;
+// Volume adjustment; instantly change if time is negative or zero. Only the envelope is set here, _process does the rest
 void MusicManager::change_volume(float target, float delay)
 {
-	volume_target = fmaxf(0.0f, target);
-	if (delay > 0.0f)
-		volume_delta = 1.0f / delay;
-	else
-		set_volume_db(Math::linear2db(target));
+	volume_fade = { volume_current, fmaxf(0.0f, target), fmaxf(delay, 0.0f), fade_clock(), fade_curve };
+	volume_fading = true;
+	if (delay <= 0.0f)
+	{
+		volume_current = volume_fade.to;
+		set_volume_db(Math::linear2db(volume_current));
+	};
 }
 
 void MusicManager::music_play(String song_id, int loop_id, float vol_target, float delay)
 {
-	std::string id = song_id.alloc_c_string();
-	if (song_defs.find(id) == song_defs.end())
+	if (find_song(song_id) < 0)
 		music_pause(delay);
 	else
-	{
-		load_song(id);
-		play_loop(loop_id);
-		change_volume(vol_target, delay);
-	};
+		queue_song(song_id, loop_id, -1.0f, vol_target, delay);
 }
 
 void MusicManager::music_pause(float delay)
 {
+	// A song still on the loader would otherwise start up over the pause
+	pending.active = false;
 	change_volume(0.0f, delay);
 	pausing = true;
 }
@@ -182,23 +612,48 @@ void MusicManager::music_pause(float delay)
 void MusicManager::music_resume(float vol_target, float delay)
 {
 	resume_loop();
-	change_volume(vol_target, delay);
+	if (pending.active)
+	{
+		pending.volume = vol_target;
+		pending.delay = delay;
+	}
+	else
+		change_volume(vol_target, delay);
+}
+
+// Get a song off the disk ahead of time, e.g. the battle music while the map loads
+void MusicManager::music_preload(String song_id)
+{
+	int song = find_song(song_id);
+	if (song < 0)
+		return;
+	loader.request(songs[song].file);
+	for (int i = 0; i < songs[song].layers.size(); i++)
+		loader.request(songs[song].layers[i].file);
 }
 
+Dictionary MusicManager::get_load_stats() { return loader.get_stats(); }
+
 Dictionary MusicManager::data_save()
 {
 	Dictionary data;
 	data["playing"] = is_playing();
 	data["pausing"] = pausing;
 	data["paused"] = get_stream_paused();
-	data["song"] = current_song.id;
-	data["loop"] = current_loop_index;
+	data["song"] = pending.active ? pending.id : current_song.id;
+	data["loop"] = pending.active ? pending.loop : current_loop_index;
 	data["keep_looping"] = keep_looping;
-	data["position"] = get_playback_position();
-	data["volume"] = Math::db2linear(get_volume_db());
-	data["volume_target"] = volume_target;
-	data["volume_delta"] = volume_delta;
+	// A song still loading hasn't started; the old song's position means nothing to it
+	if (pending.active)
+		data["position"] = fmaxf(pending.position, 0.0f);
+	else
+		data["position"] = get_playback_position();
+	data["volume"] = volume_current;
+	data["volume_target"] = volume_fade.to;
+	data["fade_remaining"] = volume_fading ? fmax(volume_fade.start + volume_fade.length - fade_clock(), 0.0) : 0.0;
+	data["fade_curve"] = volume_fade.curve;
 	data["saved_loop"] = saved_loop;
+	data["intensity"] = intensity;
 	return data;
 }
 
@@ -206,15 +661,33 @@ void MusicManager::data_load(Dictionary data)
 {
 	saved_loop = data["saved_loop"];
 	music_play(data["song"], data["loop"], data["volume_target"], 0.0f);
-	volume_delta = data["volume_delta"];
+	// Loading a save can afford to wait; everything below expects the song in place
+	if (pending.active)
+	{
+		loader.wait(songs[pending.song].file);
+		for (int i = 0; i < songs[pending.song].layers.size(); i++)
+			loader.wait(songs[pending.song].layers[i].file);
+		start_pending(false);
+	};
 	keep_looping = data["keep_looping"];
-	seek(data["position"]);
-	float v = data["volume"];
-	set_volume_db(Math::linear2db(v));
+	apply_native_loop();
+	stems_seek(data["position"]);
+	volume_current = data["volume"];
+	set_volume_db(Math::linear2db(volume_current));
+	float target = data["volume_target"], remaining = data["fade_remaining"];
+	// Older saves kept a fade rate instead of the time left
+	if (!data.has("fade_remaining") && (float)data["volume_delta"] > 0.0f)
+		remaining = fabsf(target - volume_current) / (float)data["volume_delta"];
+	int saved_curve = fade_curve;
+	fade_curve = data["fade_curve"];
+	change_volume(target, remaining);
+	fade_curve = saved_curve;
+	set_intensity(data["intensity"], 0.0f);
+	update_layers(fade_clock());
 	pausing = data["pausing"];
-	set_stream_paused(data["paused"]);
+	stems_pause(data["paused"]);
 	if ((bool)data["playing"] == false)
-		stop();
+		stems_stop();
 }
 
 void MusicManager::_init()
@@ -230,23 +703,28 @@ void MusicManager::_init()
 
 void MusicManager::_process(float delta)
 {
+	// Song finished loading
+	if (pending.active && !song_loading(pending.song))
+		start_pending(true);
 	// Volume change
-	float v = Math::db2linear(get_volume_db());
-	if (v != volume_target)
-	{
-		if (v > volume_target)
-			v = fmaxf(v - volume_delta * delta, volume_target);
-		else if (v < volume_target)
-			v = fminf(v + volume_delta * delta, volume_target);
-		set_volume_db(Math::linear2db(v));
-		// Pausing
-		if (pausing && v <= 0.0f)
+	double now = fade_clock();
+	if (volume_fading)
+	{
+		volume_current = volume_fade.value(now);
+		set_volume_db(Math::linear2db(volume_current));
+		if (volume_fade.done(now))
 		{
-			pausing = false;
-			pause_loop();
+			volume_fading = false;
+			// Pausing
+			if (pausing && volume_current <= 0.0f)
+			{
+				pausing = false;
+				pause_loop();
+			};
 		};
 	};
-	// Looping
-	if (keep_looping && get_playback_position() >= current_loop[1])
-		seek(current_loop[0]);
+	update_layers(now);
+	// Looping, for streams that can't do it themselves
+	if (keep_looping && !native_loop && get_playback_position() >= current_loop[1])
+		stems_seek(current_loop[0]);
 }
@@ -2,9 +2,7 @@
 MUSIC MANAGER CLASS
 ****************************************************/
 #pragma once
-#include <string>
 #include <vector>
-#include <unordered_map>
 #include "Godot.hpp"
 #include <Math.hpp>
 #include <ResourceLoader.hpp>
@@ -14,23 +12,82 @@ MUSIC MANAGER CLASS
 #include <JSONParseResult.hpp>
 #include "JSON.hpp"
 #include "AudioServer.hpp"
+#include "OS.hpp"
+#include "Engine.hpp"
 #include "AudioStreamPlayer.hpp"
+#include "AudioStreamSample.hpp"
+#include "AudioStreamOGGVorbis.hpp"
+#include "SongLoader.h"
 
 class MusicManager : public AudioStreamPlayer
 {
 private:
 	GODOT_CLASS(MusicManager, AudioStreamPlayer);
-	struct song_struct { String id; String name; String file; std::vector<std::vector<float>> loops; };
-	std::unordered_map<std::string, song_struct> song_defs = {};
+	enum FADE_CURVES { FADE_LINEAR, FADE_EQUAL_POWER, FADE_EXPONENTIAL };
+	// Gain envelope; worked out from the clock each time rather than stepped per frame, so a long frame
+	// lands right where the fade should be instead of stretching it
+	struct fade_struct
+	{
+		float from = 1.0f, to = 1.0f, length = 0.0f;
+		double start = 0.0;
+		int curve = FADE_LINEAR;
+		float value(double now) const;
+		bool done(double now) const { return now >= start + length; }
+	};
+	// Binary song index: magic, version, then the compiled song table. The editor builds the res:// copy that ships
+	// with the game; anything rebuilt at runtime goes to user://
+	const uint32_t SONG_INDEX_MAGIC = 0x494D4354, SONG_INDEX_VERSION = 2; // "TCMI"
+	const String SONG_INDEX_RES = "res://music/index.bin", SONG_INDEX_USER = "user://music/index.bin";
+	// Extra stem of a song, faded in as intensity goes from "from" to "to"
+	struct layer_struct { String name; String file; float from; float to; };
+	struct song_struct { String id; String name; String file; std::vector<std::vector<float>> loops; std::vector<layer_struct> layers; };
+	// Songs by interned id; song_index maps id strings to their slot
+	std::vector<song_struct> songs;
+	Dictionary song_index = {};
 	song_struct current_song;
 	int current_loop_index = 0, last_loop_index = 0;
-	float current_loop[2] = { 0.0f }, volume_target = 0.0f, volume_delta = 0.0f;
+	float current_loop[2] = { 0.0f }, volume_current = 1.0f;
+	fade_struct volume_fade;
+	bool volume_fading = false;
 	Array saved_loop;
-	bool keep_looping = true, pausing = false, resuming = true;
+	bool keep_looping = true, pausing = false, resuming = true, native_loop = false;
+	// Loop settings a stream was imported with, put back once we stop looping it natively
+	struct loop_backup { Ref<AudioStream> stream; bool loop; float offset; int mode, begin, end; };
+	std::vector<loop_backup> loop_backups;
+	// Song waiting on the loader; position < 0 plays from the top, volume < 0 leaves the volume alone
+	struct pending_struct { String id; int song = -1, loop = 0; float position = -1.0f, volume = -1.0f, delay = 0.0f; bool active = false; };
+	pending_struct pending;
+	SongLoader loader;
+	// Stem players for the current song's layers; they follow this player and only differ in gain
+	std::vector<AudioStreamPlayer*> stems;
+	std::vector<float> layer_gain;
+	std::vector<fade_struct> layer_fades;
+	float intensity = 0.0f;
 	void build_song_defs();
-	void load_song(std::string song_id);
+	Dictionary scan_song_sources();
+	void parse_song_sources(const Dictionary& sources);
+	void add_song(const song_struct& song);
+	void write_song_index(const Dictionary& sources);
+	bool read_song_index(const String& path, const Dictionary& sources);
+	void load_song(int song);
+	void queue_song(String song_id, int loop_id, float position, float vol_target, float delay);
+	void start_pending(bool waited);
+	void apply_native_loop();
+	bool native_loop_supported(Ref<AudioStream> s);
+	void native_loop_stream(Ref<AudioStream> s);
+	void restore_native_loops();
+	bool song_loading(int song);
+	void stems_play(float from);
+	void stems_seek(float to);
+	void stems_pause(bool paused);
+	void stems_stop();
+	double fade_clock();
+	void update_layers(double now);
 public:
+	int fade_curve = FADE_LINEAR;
 	static void _register_methods();
+	int find_song(const String& song_id);
+	void rebuild_song_index();
 	void play_loop(int loop_id);
 	void pause_loop();
 	void resume_loop();
@@ -40,9 +97,13 @@ public:
 	bool is_song_playing(String song_id);
 	bool is_loop_playing(int loop_id);
 	void change_volume(float target = 1.0f, float delay = 0.0f);
+	void set_intensity(float new_intensity, float delay = 1.0f);
+	float get_intensity();
 	void music_play(String song_id, int loop_id = 0, float vol_target = 1.0f, float delay = 0.0f);
 	void music_pause(float delay = 0.5f);
 	void music_resume(float vol_target = 1.0f, float delay = 1.0f);
+	void music_preload(String song_id);
+	Dictionary get_load_stats();
 	Dictionary data_save();
 	void data_load(Dictionary data);
 	void _init();
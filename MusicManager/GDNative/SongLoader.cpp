@@ -0,0 +1,168 @@
+/***************************************************
+SONG LOADER
+Background loading for MusicManager. Songs load on a
+worker thread so decoding never stalls a frame, and
+the last few stay cached for quick swaps back.
+****************************************************/
+#include "SongLoader.h"
+#include <algorithm>
+
+SongLoader::~SongLoader()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+	if (worker.joinable())
+		worker.join();
+}
+
+void SongLoader::run()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	while (true)
+	{
+		wake.wait(guard, [this] { return quit || !jobs.empty(); });
+		if (quit)
+			return;
+		Job job = jobs.front();
+		jobs.pop_front();
+		guard.unlock();
+		Done d = load(job);
+		guard.lock();
+		done.push_back(d);
+		finished.notify_all();
+	};
+}
+
+SongLoader::Done SongLoader::load(const Job& job)
+{
+	Ref<AudioStream> stream = ResourceLoader::get_singleton()->load(job.path);
+	std::chrono::duration<float, std::milli> latency = std::chrono::steady_clock::now() - job.requested;
+	return { job.path, stream, latency.count() };
+}
+
+// Move finished loads into the cache, pushing out whichever song went unused the longest
+void SongLoader::collect()
+{
+	std::vector<Done> finished;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		finished.swap(done);
+	}
+	for (int i = 0; i < finished.size(); i++)
+	{
+		const Done& d = finished[i];
+		in_flight.erase(std::remove(in_flight.begin(), in_flight.end(), d.path), in_flight.end());
+		if (latencies.size() < LATENCY_SAMPLES)
+			latencies.push_back(d.latency_ms);
+		else
+			latencies[latency_next] = d.latency_ms;
+		latency_next = (latency_next + 1) % LATENCY_SAMPLES;
+		loads_total++;
+		// Failed loads aren't cached so a later request can try again
+		if (d.stream.is_null())
+			continue;
+		if (cache.size() >= CACHE_SIZE)
+		{
+			int oldest = 0;
+			for (int j = 1; j < cache.size(); j++)
+				if (cache[j].last_used < cache[oldest].last_used)
+					oldest = j;
+			cache.erase(cache.begin() + oldest);
+		};
+		cache.push_back({ d.path, d.stream, ++use_counter });
+	};
+}
+
+SongLoader::Entry* SongLoader::find(const String& path)
+{
+	for (int i = 0; i < cache.size(); i++)
+		if (cache[i].path == path)
+			return &cache[i];
+	return nullptr;
+}
+
+void SongLoader::request(const String& path)
+{
+	collect();
+	Entry* e = find(path);
+	if (e != nullptr)
+	{
+		e->last_used = ++use_counter;
+		return;
+	};
+	if (std::find(in_flight.begin(), in_flight.end(), path) != in_flight.end())
+		return;
+	in_flight.push_back(path);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back({ path, std::chrono::steady_clock::now() });
+	}
+	if (!worker.joinable())
+		worker = std::thread(&SongLoader::run, this);
+	wake.notify_one();
+}
+
+bool SongLoader::is_pending(const String& path)
+{
+	collect();
+	return std::find(in_flight.begin(), in_flight.end(), path) != in_flight.end();
+}
+
+void SongLoader::wait(const String& path)
+{
+	if (!is_pending(path))
+		return;
+	std::unique_lock<std::mutex> guard(lock);
+	for (std::deque<Job>::iterator j = jobs.begin(); j != jobs.end(); j++)
+		if (j->path == path)
+		{
+			Job job = *j;
+			jobs.erase(j);
+			guard.unlock();
+			Done d = load(job);
+			guard.lock();
+			done.push_back(d);
+			break;
+		};
+	// Otherwise the worker already has it
+	finished.wait(guard, [this, &path] {
+		for (int i = 0; i < done.size(); i++)
+			if (done[i].path == path)
+				return true;
+		return false;
+	});
+	guard.unlock();
+	collect();
+}
+
+Ref<AudioStream> SongLoader::get(const String& path)
+{
+	collect();
+	Entry* e = find(path);
+	if (e == nullptr)
+		return Ref<AudioStream>();
+	e->last_used = ++use_counter;
+	return e->stream;
+}
+
+Dictionary SongLoader::get_stats()
+{
+	collect();
+	std::vector<float> sorted = latencies;
+	std::sort(sorted.begin(), sorted.end());
+	Dictionary stats;
+	stats["loads_total"] = loads_total;
+	stats["cached"] = int(cache.size());
+	stats["pending"] = int(in_flight.size());
+	if (sorted.empty())
+		return stats;
+	int last = int(sorted.size()) - 1;
+	stats["p50_ms"] = sorted[last * 50 / 100];
+	stats["p90_ms"] = sorted[last * 90 / 100];
+	stats["p99_ms"] = sorted[last * 99 / 100];
+	stats["max_ms"] = sorted[last];
+	return stats;
+}
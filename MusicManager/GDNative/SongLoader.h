@@ -0,0 +1,58 @@
+/***************************************************
+SONG LOADER
+Background loading for MusicManager. Songs load on a
+worker thread so decoding never stalls a frame, and
+the last few stay cached for quick swaps back.
+****************************************************/
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Godot.hpp"
+#include <ResourceLoader.hpp>
+#include "AudioStream.hpp"
+
+class SongLoader
+{
+public:
+	static const int CACHE_SIZE = 8, LATENCY_SAMPLES = 64;
+
+	~SongLoader();
+	// Start loading in the background; cached or already queued songs are left alone
+	void request(const String& path);
+	// Still on the worker thread
+	bool is_pending(const String& path);
+	// Block until a requested song is done; one that hasn't started yet is loaded here instead of waiting its turn
+	void wait(const String& path);
+	// Cached stream, or null if it isn't loaded (yet)
+	Ref<AudioStream> get(const String& path);
+	// Request to ready times for the last LATENCY_SAMPLES loads
+	Dictionary get_stats();
+private:
+	struct Job { String path; std::chrono::steady_clock::time_point requested; };
+	struct Done { String path; Ref<AudioStream> stream; float latency_ms; };
+	struct Entry { String path; Ref<AudioStream> stream; uint64_t last_used; };
+
+	// Shared with the worker, guarded by lock
+	std::mutex lock;
+	std::condition_variable wake, finished;
+	std::deque<Job> jobs;
+	std::vector<Done> done;
+	bool quit = false;
+	std::thread worker;
+
+	// Main thread only
+	std::vector<String> in_flight;
+	std::vector<Entry> cache;
+	std::vector<float> latencies;
+	int latency_next = 0, loads_total = 0;
+	uint64_t use_counter = 0;
+
+	void run();
+	Done load(const Job& job);
+	void collect();
+	Entry* find(const String& path);
+};
@@ -0,0 +1,11 @@
+tool
+extends EditorScript
+
+# Compiles every musicdb .json into res://music/index.bin so it ships with the export.
+# Open in the script editor and use File > Run (Ctrl+Shift+X) after changing a musicdb file.
+
+func _run():
+	var music = preload("MusicManager.gdns").new()
+	music.rebuild_song_index()
+	music.free()
+	print("MusicManager: song index written to res://music/index.bin")
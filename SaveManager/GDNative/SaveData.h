@@ -0,0 +1,18 @@
+/*******************************************************************************
+SAVE DATA
+Helpers for reading values back out of data_load() Dictionaries. Binary saves
+keep Vector3s typed, so they come straight back; version 1 JSON saves flattened
+them to "(x, y, z)" strings, which still get parsed for the sake of old saves.
+*******************************************************************************/
+#pragma once
+#include "Common.h"
+#include "GameManager.h"
+
+inline Vector3 data_vec3(const Variant& v)
+{
+	if (v.get_type() == Variant::VECTOR3)
+		return v;
+	if (v.get_type() == Variant::STRING)
+		return GameManager::str_to_vec3(v);
+	return Vector3::ZERO;
+}
@@ -76,22 +76,22 @@ void Actor::data_load(Dictionary data)
 	// Navigation
 	set_collision_layer(data["col_layer"]);
 	set_collision_mask(data["col_mask"]);
-	set_translation(GameManager::str_to_vec3(data["origin"]));
-	set_rotation(GameManager::str_to_vec3(data["rotation"]));
-	set_scale(GameManager::str_to_vec3(data["scale"]));
-	velocity = GameManager::str_to_vec3(data["velocity"]);
-	grav_dir = GameManager::str_to_vec3(data["grav_dir"]);
-	grav_vector = GameManager::str_to_vec3(data["grav_vector"]);
+	set_translation(data_vec3(data["origin"]));
+	set_rotation(data_vec3(data["rotation"]));
+	set_scale(data_vec3(data["scale"]));
+	velocity = data_vec3(data["velocity"]);
+	grav_dir = data_vec3(data["grav_dir"]);
+	grav_vector = data_vec3(data["grav_vector"]);
 	flying = data["flying"];
-	move_input = GameManager::str_to_vec3(data["move_input"]);
+	move_input = data_vec3(data["move_input"]);
 	on_floor = data["on_floor"];
 	jumping = data["jumping"];
 	check_bottom = data["check_bottom"];
 	water_level = data["water_level"];
 	water_vol = data["water_vol"];
 	water_type = data["water_type"];
-	nav_dir = GameManager::str_to_vec3(data["nav_dir"]);
-	nav_target_pos = GameManager::str_to_vec3(data["nav_target_pos"]);
+	nav_dir = data_vec3(data["nav_dir"]);
+	nav_target_pos = data_vec3(data["nav_target_pos"]);
 	max_speed = data["max_speed"];
 	// Health
 	health_max = data["health_max"];
@@ -113,7 +113,7 @@ void Actor::data_load(Dictionary data)
 	{
 		enemy = cast_to<Spatial>(get_node(enemy_path));
 	};
-	last_enemy_pos = GameManager::str_to_vec3(data["last_enemy_pos"]);
+	last_enemy_pos = data_vec3(data["last_enemy_pos"]);
 	hunt_time = data["hunt_time"];
 	hearing_range = data["hearing_range"];
 	path_name = data["path_name"];
@@ -155,7 +155,7 @@ void Player::data_load(Dictionary data)
 {
 	Actor::data_load(data);
 	cam_x_rotation = data["cam_x_rotation"];
-	camera->set_rotation(GameManager::str_to_vec3(data["camera_rotation"]));
+	camera->set_rotation(data_vec3(data["camera_rotation"]));
 	items = data["items"];
 	weapons = data["weapons"];
 	wep_id = data["wep_id"];
@@ -8,6 +8,7 @@ void SaveManager::_register_methods()
 {
 	register_method("save_game", &SaveManager::save_game);
 	register_method("load_game", &SaveManager::load_game);
+	register_method("export_save_json", &SaveManager::export_save_json);
 	register_method("_load_game", &SaveManager::_load_game);
 	register_method("_load_player", &SaveManager::_load_player);
 	register_method("_ready", &SaveManager::_ready);
@@ -102,63 +103,198 @@ void SaveManager::load_config()
 	CTRL->set_gamepad_invert_y(cfg->get_value("Controls", "gamepad_invert_y", CTRL->get_gamepad_invert_y()));
 }
 
+String SaveManager::save_path(int data_id)
+{
+	if (data_id >= 0)
+		return "user://saves/" + String::num(data_id) + ".sav";
+	return "user://saves/quick.sav";
+}
+
+// Chunk lengths get patched in once the payload is written
+void SaveManager::chunk_begin(Ref<File> file, uint32_t tag)
+{
+	file->store_32(tag);
+	chunk_start = file->get_position();
+	file->store_32(0);
+}
+
+void SaveManager::chunk_end(Ref<File> file)
+{
+	int64_t end = file->get_position();
+	file->seek(chunk_start);
+	file->store_32(end - chunk_start - 4);
+	file->seek(end);
+}
+
+int SaveManager::save_string(Dictionary& str_ids, Array& new_strs, const String& s)
+{
+	if (str_ids.has(s))
+		return str_ids[s];
+	int id = str_ids.size();
+	str_ids[s] = id;
+	new_strs.append(s);
+	return id;
+}
+
 bool SaveManager::save_game(int data_id)
 {
 	if (GAME->get_game_mode() != GameManager::SINGLEPLAYER)
 		return false;
-	Dictionary data;
 	Ref<File> file = Ref<File>(File::_new());
-	Error file_chk;
-	if (data_id >= 0)
-		file_chk = file->open("user://saves/" + String::num(data_id) + ".sav", File::WRITE);
-	else
-		file_chk = file->open("user://saves/quick.sav", File::WRITE);
-	if (file_chk != Error::OK)
+	if (file->open(save_path(data_id), File::WRITE) != Error::OK)
 	{
 		String msg = (data_id >= 0) ? "Unable to save game!" : "Unable to quicksave!";
 		GAME->trigger_notification(msg);
 		return false;
 	};
-	data["save_version"] = SAVE_VERSION;
-	data["save_id"] = data_id;
-	data["start_status"] = GAME->get_start_status();
-	data["map"] = GAME->current_map.id;
-	data["mapname"] = GAME->current_map.name;
-	data["time"] = GAME->get_time();
-	Dictionary ent_data = {};
+	file->store_32(SAVE_MAGIC);
+	file->store_32(SAVE_VERSION);
+	Dictionary meta;
+	meta["save_id"] = data_id;
+	meta["start_status"] = GAME->get_start_status();
+	meta["map"] = GAME->current_map.id;
+	meta["mapname"] = GAME->current_map.name;
+	meta["time"] = GAME->get_time();
+	meta["timestamp"] = OS::get_singleton()->get_unix_time();
+	chunk_begin(file, CH_META);
+	file->store_var(meta);
+	chunk_end(file);
+	// Entities go straight to disk as they're gathered; only one data_save() result is alive at a time
+	Dictionary str_ids;
+	Array new_strs;
+	PoolIntArray field_ids;
 	Array ents = get_tree()->get_nodes_in_group("SAV");
 	for (int i = 0; i < ents.size(); i++)
 	{
 		Node* e = ents[i];
-		if (e->has_method("data_save"))
-			ent_data[String(e->get_path())] = e->call("data_save");
+		if (!e->has_method("data_save"))
+			continue;
+		Dictionary ent_data = e->call("data_save");
+		Array fields = ent_data.keys();
+		int path_id = save_string(str_ids, new_strs, String(e->get_path()));
+		field_ids.resize(0);
+		for (int f = 0; f < fields.size(); f++)
+			field_ids.append(save_string(str_ids, new_strs, fields[f]));
+		if (new_strs.size() > 0)
+		{
+			chunk_begin(file, CH_STRINGS);
+			file->store_32(new_strs.size());
+			for (int s = 0; s < new_strs.size(); s++)
+				file->store_pascal_string(new_strs[s]);
+			chunk_end(file);
+			new_strs.clear();
+		};
+		chunk_begin(file, CH_ENTITY);
+		file->store_32(path_id);
+		file->store_32(fields.size());
+		for (int f = 0; f < fields.size(); f++)
+		{
+			file->store_32(field_ids[f]);
+			// Node references can't survive a reload anyway; JSON saves turned them into junk strings
+			Variant v = ent_data[fields[f]];
+			if (v.get_type() == Variant::OBJECT)
+				v = Variant();
+			file->store_var(v);
+		};
+		chunk_end(file);
 	};
-	data["entities"] = ent_data;
-	file->store_line(data.to_json());
+	chunk_begin(file, CH_END);
+	chunk_end(file);
 	String msg = (data_id >= 0) ? "Game saved" : "Game quicksaved";
 	GAME->trigger_notification(msg);
 	file->close();
+	Ref<ConfigFile> index = Ref<ConfigFile>(ConfigFile::_new());
+	index->load(SAVE_INDEX);
+	meta["save_version"] = SAVE_VERSION;
+	index_store(index, save_path(data_id).get_file(), meta);
+	index->save(SAVE_INDEX);
 	return true;
 }
 
+// Reads either format into the same Dictionary layout the JSON saves used
+bool SaveManager::read_save(const String& path, Dictionary& data, bool header_only)
+{
+	Ref<File> file = Ref<File>(File::_new());
+	if (file->open(path, File::READ) != Error::OK)
+		return false;
+	if (file->get_len() < 8 || file->get_32() != SAVE_MAGIC)
+	{
+		// Version 1 saves are one big JSON Dictionary
+		Variant parsed = JSON::get_singleton()->parse(file->get_as_text())->get_result();
+		file->close();
+		if (parsed.get_type() != Variant::DICTIONARY)
+			return false;
+		data = parsed;
+		return true;
+	};
+	data["save_version"] = int64_t(file->get_32());
+	Array strs;
+	Dictionary ent_data;
+	bool ok = false;
+	while (file->get_position() + 8 <= file->get_len())
+	{
+		uint32_t tag = file->get_32();
+		int64_t next = file->get_position() + 4;
+		next += file->get_32();
+		if (tag == CH_META)
+		{
+			Dictionary meta = file->get_var();
+			Array keys = meta.keys();
+			for (int i = 0; i < keys.size(); i++)
+				data[keys[i]] = meta[keys[i]];
+			if (header_only)
+			{
+				ok = true;
+				break;
+			};
+		}
+		else if (tag == CH_STRINGS)
+		{
+			int count = file->get_32();
+			for (int i = 0; i < count; i++)
+				strs.append(file->get_pascal_string());
+		}
+		else if (tag == CH_ENTITY)
+		{
+			int path_id = file->get_32(), count = file->get_32();
+			if (path_id >= strs.size())
+				break;
+			Dictionary ent;
+			for (int i = 0; i < count; i++)
+			{
+				int field_id = file->get_32();
+				if (field_id >= strs.size())
+					break;
+				ent[strs[field_id]] = file->get_var();
+			};
+			ent_data[strs[path_id]] = ent;
+		}
+		else if (tag == CH_END)
+		{
+			ok = true;
+			break;
+		};
+		// Unknown chunks from newer versions get skipped
+		file->seek(next);
+	};
+	file->close();
+	if (!header_only)
+		data["entities"] = ent_data;
+	return ok;
+}
+
 bool SaveManager::load_game(int data_id)
 {
 	if (GAME->get_game_mode() != GameManager::SINGLEPLAYER)
 		return false;
-	Ref<File> file = Ref<File>(File::_new());
-	Error file_chk;
-	if (data_id >= 0)
-		file_chk = file->open("user://saves/" + String::num(data_id) + ".sav", File::READ);
-	else
-		file_chk = file->open("user://saves/quick.sav", File::READ);
-	if (file_chk == Error::OK)
+	Dictionary data;
+	if (read_save(save_path(data_id), data))
 	{
-		Dictionary data = (Dictionary)JSON::get_singleton()->parse(file->get_as_text())->get_result();
 		// Need a handler to omit any saves that don't match the current version
-		if ((int)data["save_version"] != SAVE_VERSION)
+		int version = data["save_version"];
+		if (version != SAVE_VERSION && version != SAVE_VERSION_JSON)
 		{
 			GAME->trigger_notification("Incorrect save version!");
-			file->close();
 			return false;
 		};
 		String msg = (data_id >= 0) ? "Loading save..." : "Loading quicksave...";
@@ -166,7 +302,6 @@ bool SaveManager::load_game(int data_id)
 		load_cache = data;
 		GAME->set_start_status(data["start_status"]);
 		GAME->change_map(data["map"]);
-		file->close();
 		return true;
 	};
 	String msg = (data_id >= 0) ? "Unable to load save!" : "Unable to load quicksave!";
@@ -174,6 +309,21 @@ bool SaveManager::load_game(int data_id)
 	return false;
 }
 
+// Debugging aid; dumps a save of either format next to it as readable JSON
+bool SaveManager::export_save_json(int data_id)
+{
+	Dictionary data;
+	String path = save_path(data_id);
+	if (!read_save(path, data))
+		return false;
+	Ref<File> file = Ref<File>(File::_new());
+	if (file->open(path.get_basename() + ".json", File::WRITE) != Error::OK)
+		return false;
+	file->store_line(data.to_json());
+	file->close();
+	return true;
+}
+
 void SaveManager::_load_game()
 {
 	if (load_cache.empty())
@@ -227,12 +377,56 @@ void SaveManager::_load_player()
 	player_cache.clear();
 }
 
+// Index entries only count while the save's modified time still matches what was recorded
+void SaveManager::index_store(Ref<ConfigFile> index, const String& filename, const Dictionary& data)
+{
+	Ref<File> file = Ref<File>(File::_new());
+	index->set_value(filename, "modified", file->get_modified_time("user://saves/" + filename));
+	index->set_value(filename, "save_id", data.has("save_id") ? data["save_id"] : Variant(-1));
+	index->set_value(filename, "save_version", data.has("save_version") ? data["save_version"] : Variant(SAVE_VERSION_JSON));
+	index->set_value(filename, "mapname", data.has("mapname") ? data["mapname"] : Variant(""));
+	index->set_value(filename, "time", data.has("time") ? data["time"] : Variant(0.0f));
+	index->set_value(filename, "timestamp", data.has("timestamp") ? data["timestamp"] : Variant(0));
+	index_dirty = true;
+}
+
+// Falls back to reading the save's header when the entry is missing or stale
+bool SaveManager::index_read(Ref<ConfigFile> index, const String& filename, Dictionary& data)
+{
+	Ref<File> file = Ref<File>(File::_new());
+	int64_t modified = file->get_modified_time("user://saves/" + filename);
+	if (!index->has_section(filename) || int64_t(index->get_value(filename, "modified", -1)) != modified)
+	{
+		if (!read_save("user://saves/" + filename, data, true))
+			return false;
+		index_store(index, filename, data);
+		return true;
+	};
+	data["save_id"] = index->get_value(filename, "save_id", -1);
+	data["save_version"] = index->get_value(filename, "save_version", SAVE_VERSION_JSON);
+	data["mapname"] = index->get_value(filename, "mapname", "");
+	data["time"] = index->get_value(filename, "time", 0.0f);
+	data["timestamp"] = index->get_value(filename, "timestamp", 0);
+	return true;
+}
+
 Array SaveManager::get_save_list(bool empty_slots)
 {
 	Array save_list = {};
 	Ref<Directory> dir = Ref<Directory>(Directory::_new());
 	if (dir->open("user://saves") == Error::OK)
 	{
+		// A missing or broken index just means every entry gets rebuilt below
+		Ref<ConfigFile> index = Ref<ConfigFile>(ConfigFile::_new());
+		index->load(SAVE_INDEX);
+		index_dirty = false;
+		PoolStringArray sections = index->get_sections();
+		for (int s = 0; s < sections.size(); s++)
+			if (!dir->file_exists(sections[s]))
+			{
+				index->erase_section(sections[s]);
+				index_dirty = true;
+			};
 		dir->list_dir_begin();
 		String filename = dir->get_next();
 		int i = 10;
@@ -240,10 +434,9 @@ Array SaveManager::get_save_list(bool empty_slots)
 		{
 			if (filename.rfind(".sav") > -1)
 			{
-				Ref<File> file = Ref<File>(File::_new());
-				if (file->open(dir->get_current_dir() + "/" + filename, File::READ) == Error::OK)
+				Dictionary data;
+				if (index_read(index, filename, data))
 				{
-					Dictionary data = (Dictionary)JSON::get_singleton()->parse(file->get_as_text())->get_result();
 					String s = (filename == "quick.sav") ? "Quicksave - " : "";
 					String m = data["mapname"];
 					if (m.length() > 20)
@@ -253,13 +446,14 @@ Array SaveManager::get_save_list(bool empty_slots)
 					if (empty_slots && filename == "quick.sav")
 						save_list.remove(save_list.size() - 1);
 					i--;
-					file->close();
 				};
 			};
 			filename = dir->get_next();
 		};
 		if (empty_slots && i > 1)
 			save_list.append(String("--- Unused Slot ---"));
+		if (index_dirty)
+			index->save(SAVE_INDEX);
 	};
 	return save_list;
 }
@@ -18,15 +18,37 @@ class SaveManager : public Node
 {
 private:
 	GODOT_CLASS(SaveManager, Node);
-	const int CONFIG_VERSION = 2, SAVE_VERSION = 1;
+	const int CONFIG_VERSION = 2, SAVE_VERSION = 2, SAVE_VERSION_JSON = 1;
+	// Binary saves: magic, version, then chunks of [tag][byte length][payload]
+	// Tags are four character codes, little endian
+	enum SAVE_CHUNKS : uint32_t
+	{
+		SAVE_MAGIC = 0x56534354,	// "TCSV"
+		CH_META = 0x4154454D,		// "META" header Dictionary; always the first chunk
+		CH_STRINGS = 0x53525453,	// "STRS" strings appended to the string table
+		CH_ENTITY = 0x20544E45,		// "ENT " path id, field count, then field id + value pairs
+		CH_END = 0x20444E45			// "END "
+	};
 	ControlsManager* CTRL; GameManager* GAME; MusicManager* MUSIC;
 	Dictionary load_cache = {}, player_cache = {};
+	int64_t chunk_start = 0;
+	String save_path(int data_id);
+	void chunk_begin(Ref<File> file, uint32_t tag);
+	void chunk_end(Ref<File> file);
+	int save_string(Dictionary& str_ids, Array& new_strs, const String& s);
+	bool read_save(const String& path, Dictionary& data, bool header_only = false);
+	// Sidecar index of save headers, keyed by file name
+	const String SAVE_INDEX = "user://saves/index.cfg";
+	bool index_dirty = false;
+	void index_store(Ref<ConfigFile> index, const String& filename, const Dictionary& data);
+	bool index_read(Ref<ConfigFile> index, const String& filename, Dictionary& data);
 public:
 	static void _register_methods();
 	void save_config();
 	void load_config();
 	bool save_game(int data_id = -1);
 	bool load_game(int data_id = -1);
+	bool export_save_json(int data_id = -1);
 	void _load_game();
 	void _load_player();
 	Array get_save_list(bool empty_slots = false);
@@ -1,4 +1,6 @@
 #include "SpriteText.h"
+#include <algorithm>
+#include <deque>
 
 /*******************************************************************************
 SPRITE FONT CLASS ============================================================
@@ -20,9 +22,214 @@ void SpriteFont::set_character_size(Vector2 new_character_size)
 }
 
 Vector2 SpriteFont::get_character_size() { return character_size; }
-void SpriteFont::set_character_set(String new_character_set) { character_set = new_character_set; }
+void SpriteFont::set_character_set(String new_character_set)
+{
+	character_set = new_character_set;
+	char_map.build(character_set);
+}
+
 String SpriteFont::get_character_set() { return character_set; }
-void SpriteFont::_init() { set_character_size(character_size); }
+
+void SpriteFont::_init()
+{
+	set_character_size(character_size);
+	char_map.build(character_set);
+}
+
+SpriteCharMap::SpriteCharMap()
+{
+	for (int i = 0; i < 128; i++)
+		ascii[i] = -1;
+}
+
+// Duplicates keep their first frame, same as searching the set would
+void SpriteCharMap::build(String character_set)
+{
+	for (int i = 0; i < 128; i++)
+		ascii[i] = -1;
+	others.clear();
+	for (int i = 0; i < character_set.length(); i++)
+	{
+		wchar_t c = character_set[i];
+		if (c >= 0 && c < 128)
+		{
+			if (ascii[c] < 0)
+				ascii[c] = i;
+		}
+		else
+			others.push_back(std::make_pair(c, i));
+	};
+	std::stable_sort(others.begin(), others.end(), [](const std::pair<wchar_t, int>& a, const std::pair<wchar_t, int>& b) { return a.first < b.first; });
+	others.erase(std::unique(others.begin(), others.end(), [](const std::pair<wchar_t, int>& a, const std::pair<wchar_t, int>& b) { return a.first == b.first; }), others.end());
+}
+
+int SpriteCharMap::find(wchar_t c) const
+{
+	if (c >= 0 && c < 128)
+		return ascii[c];
+	std::vector<std::pair<wchar_t, int>>::const_iterator itr = std::lower_bound(others.begin(), others.end(), std::make_pair(c, -1));
+	if (itr != others.end() && itr->first == c)
+		return itr->second;
+	return -1;
+}
+
+// A deque so entries keep their address as fonts are added; SpriteTexts point straight at them.
+// Only a handful of fonts ever load, so the paths are just searched in order
+static std::deque<SpriteFontMetrics> metrics_cache;
+static std::vector<String> metrics_paths;
+
+const SpriteFontMetrics* SpriteFont::get_metrics(String path)
+{
+	for (int i = 0; i < metrics_paths.size(); i++)
+		if (metrics_paths[i] == path)
+			return &metrics_cache[i];
+	Ref<PackedScene> scene = ResourceLoader::get_singleton()->load(path);
+	if (scene.is_null())
+		return nullptr;
+	Node* n = scene->instance();
+	SpriteFont* c = cast_to<SpriteFont>(n);
+	if (c == nullptr)
+	{
+		if (n != nullptr)
+			n->free();
+		return nullptr;
+	};
+	SpriteFontMetrics m;
+	m.scene = scene;
+	m.character_size = c->get_character_size();
+	m.hframes = c->get_hframes();
+	m.vframes = c->get_vframes();
+	m.character_set = c->get_character_set();
+	m.char_map = c->char_map;
+	c->free();
+	metrics_paths.push_back(path);
+	metrics_cache.push_back(m);
+	return &metrics_cache.back();
+}
+
+// Scenes and Strings held here have to be released before the library is
+void SpriteFont::clear_metrics()
+{
+	metrics_cache.clear();
+	metrics_paths.clear();
+}
+
+/*******************************************************************************
+SPRITE TEXT LAYOUT CLASS =====================================================
+Works out where each glyph of a text goes without touching any nodes. The text is
+scanned once up front for word lengths, then laid out one character per step, so
+typewriter writing only ever lays out what has just been revealed.
+*******************************************************************************/
+void SpriteTextLayout::clear()
+{
+	px = 0;
+	py = 0;
+	last_col.clear();
+	set_text("");
+}
+
+// One backwards pass finds the next space and newline after every character,
+// which is all the word wrap ever needs to know
+void SpriteTextLayout::set_text(String new_text)
+{
+	text = new_text;
+	pos = 0;
+	int len = text.length();
+	next_space.resize(len + 1);
+	next_newline.resize(len + 1);
+	next_space[len] = -1;
+	next_newline[len] = -1;
+	for (int i = len - 1; i >= 0; i--)
+	{
+		next_space[i] = (text[i] == L' ') ? i : next_space[i + 1];
+		next_newline[i] = (text[i] == L'\n') ? i : next_newline[i + 1];
+	};
+}
+
+bool SpriteTextLayout::is_done() const { return pos >= text.length(); }
+
+int SpriteTextLayout::get_last_col(int line) const
+{
+	if (line < 0 || line >= last_col.size())
+		return -1;
+	return last_col[line];
+}
+
+bool SpriteTextLayout::step(Step& s)
+{
+	int len = text.length();
+	if (pos >= len)
+		return false;
+	int i = pos;
+	pos++;
+	s.has_glyph = false;
+	s.is_space = false;
+	// Newline
+	if (text[i] == L'\n')
+	{
+		py += 1;
+		px = 0;
+	}
+	else if (text[i] == L'\\' && i + 1 < len && text[i + 1] == L'n')
+	{
+		py += 1;
+		px = 0;
+		pos++;
+	}
+	// Space
+	else if (text[i] == L' ')
+	{
+		s.is_space = true;
+		px += 1;
+		if (word_wrap)
+		{
+			int next_word_length = (next_space[i + 1] < 0) ? len - i - 1 : next_space[i + 1] - i - 1;
+			// We only wrap if we don't find a newline in the middle of our word
+			int nl = next_newline[i + 1];
+			if (nl == -1 || nl > i + next_word_length)
+				if ((px + next_word_length) * advance >= box_width)
+				{
+					py += 1;
+					px = 0;
+				};
+		};
+		if (px > 0)
+		{
+			s.has_glyph = true;
+			s.glyph = { -1, -1, py, px };
+		};
+	}
+	// Standard character
+	else
+	{
+		int frame;
+		// Are we trying to parse a control hint?
+		if (text[i] == L'$' && i + 3 < len && text[i + 1] == L'c')
+		{
+			frame = int(Math::clamp(int(text[i + 2]) * 10 + int(text[i + 3]), 0, 48));
+			pos += 3;
+		}
+		// Find the correct character in our text texture
+		else
+		{
+			frame = (char_map != nullptr) ? char_map->find(text[i]) : -1;
+			if (frame >= 0)
+				frame = Math::min(frame, frame_count);
+		};
+		if (float(px) * advance >= box_width)
+		{
+			py += 1;
+			px = 0;
+		};
+		s.has_glyph = true;
+		s.glyph = { i, frame, py, px };
+		if (last_col.size() <= py)
+			last_col.resize(py + 1, -1);
+		last_col[py] = px;
+		px += 1;
+	};
+	return true;
+}
 
 /*******************************************************************************
 SPRITE TEXT CLASS ============================================================
@@ -57,7 +264,6 @@ void SpriteText::_register_methods()
 	register_method("set_font_shader_res", &SpriteText::set_font_shader_res);
 	register_method("clear", &SpriteText::clear);
 	register_method("write", &SpriteText::write);
-	register_method("write_char", &SpriteText::write_char);
 
 	// Base Processing
 	register_method("_ready", &SpriteText::_ready);
@@ -88,10 +294,12 @@ int SpriteText::get_font() { return font_index; }
 
 void SpriteText::set_font_res(String new_font_res)
 {
-	font_res = ResourceLoader::get_singleton()->load(new_font_res);
-	Sprite* c = cast_to<Sprite>(font_res->instance());
-	font_size = c->get("character_size");
-	c->free();
+	const SpriteFontMetrics* metrics = SpriteFont::get_metrics(new_font_res);
+	if (metrics == nullptr)
+		return;
+	font_metrics = metrics;
+	font_res = font_metrics->scene;
+	font_size = font_metrics->character_size;
 }
 
 Ref<PackedScene> SpriteText::get_font_res() { return font_res; }
@@ -127,8 +335,10 @@ void SpriteText::clear()
 	ReferenceRect* scr = cast_to<ReferenceRect>(get_node("scroll"));
 	while (scr->get_child_count() > 0)
 		scr->get_child(0)->free();
+	glyphs.clear();
+	align_from = -1;
+	layout.clear();
 	text = "";
-	write_pos = Vector2::ZERO;
 	scr->set_size(Vector2(scr->get_size().x, font_size.y));
 	scr->set_position(Vector2::ZERO);
 }
@@ -140,8 +350,20 @@ void SpriteText::write(String new_text, bool clear_text)
 	if (clear_text)
 		clear();
 	set_font_res(font_sources[font_index]);
+	// Nothing to write with until a font has loaded
+	if (font_metrics == nullptr)
+	{
+		text = "";
+		return;
+	};
 	text = new_text;
-	write_progress = 0;
+	layout.box_width = get_size().x;
+	layout.advance = font_size.x * font_scale.x + text_margin.x;
+	layout.word_wrap = word_wrap;
+	layout.char_map = &font_metrics->char_map;
+	layout.frame_count = font_metrics->hframes * font_metrics->vframes;
+	layout.set_text(text);
+	write_finished = false;
 	write_ct = 0.0f;
 	write_loop(get_process_delta_time(), cast_to<ReferenceRect>(get_node("scroll")));
 }
@@ -149,15 +371,15 @@ void SpriteText::write(String new_text, bool clear_text)
 void SpriteText::write_loop(float delta, ReferenceRect* scr)
 {
 	// Writing
-	if (write_progress < text.length())
+	bool wrote = false;
+	if (!layout.is_done())
 	{
 		// Instant gratification
 		if (write_speed < 0.0f)
 		{
-			for (int i = 0; i < text.length() - write_progress; i++)
-				if (is_inside_tree())
-					write_char(i + write_progress);
-			write_progress = text.length();
+			if (is_inside_tree())
+				while (write_step(scr));
+			wrote = true;
 		}
 		// Typewriter effect
 		else
@@ -165,138 +387,123 @@ void SpriteText::write_loop(float delta, ReferenceRect* scr)
 			if (write_ct <= 0)
 			{
 				write_ct = write_speed;
-				write_char(write_progress);
-				write_progress++;
+				write_step(scr);
+				wrote = true;
 			}
 			else
 				write_ct -= delta;
 		};
 	};
+	if (wrote)
+	{
+		align_glyphs(scr);
+		float fy = font_size.y * font_scale.y + text_margin.y;
+		scr->set_size(Vector2(scr->get_size().x, float(layout.py + 1) * fy + 1.0f));
+	};
 
 	// Finish writing
-	if (write_progress == text.length())
+	if (layout.is_done() && !write_finished)
 	{
-		write_progress++;
+		write_finished = true;
 		emit_signal("write_complete");
 	};
-	if (scr->get_child_count() > MAX_CHARS)
-		scr->get_child(0)->queue_free();
+	trim_glyphs(scr);
 }
 
-void SpriteText::write_char(int i)
+// Returns false once there's nothing left to write
+bool SpriteText::write_step(ReferenceRect* scr)
 {
-	if (i >= text.length())
-		return;
-	float px = write_pos.x, py = write_pos.y;
-	float fx = font_size.x * font_scale.x + text_margin.x, fy = font_size.y * font_scale.y + text_margin.y;
-	ReferenceRect* scr = cast_to<ReferenceRect>(get_node("scroll"));
-	// Create the character
-	// Newline
-	if (text[i] == L'\n')
-	{
-		py += 1;
-		px = 0;
-	}
-	else if (text[i] == L'\\' && text[i + 1] == L'n')
-	{
-		py += 1;
-		px = 0;
-		write_progress++;
-	}
-	// Space
-	else if (text[i] == L' ')
-	{
+	SpriteTextLayout::Step s;
+	if (!layout.step(s))
+		return false;
+	// Spaces don't hold up the typewriter
+	if (s.is_space)
 		write_ct = 0.0f;
-		px += 1;
-		if (word_wrap)
-		{
-			if (text.find(" ", i + 1) == -1)
-				next_word_length = text.length() - i - 1;
-			else
-				next_word_length = text.find(" ", i + 1) - i - 1;
-			// We only wrap if we don't find a newline in the middle of our word
-			if (text.find("\n", i + 1) == -1 || text.find("\n", i + 1) > i + next_word_length)
-				if ((px + next_word_length) * fx >= get_size().x)
-				{
-					py += 1;
-					px = 0;
-				};
-		};
-		if (px > 0)
-		{
-			SpriteFont* c = cast_to<SpriteFont>(font_res->instance());
-			c->hide();
-			c->set_scale(font_scale);
-			scr->add_child(c);
-			c->set_owner(scr);
-			c->set_position(Vector2(px * fx, py * fy));
-		};
-	}
-	// Standard character
+	if (s.has_glyph)
+		add_glyph(s.glyph, scr);
+	return true;
+}
+
+// Frame -1 is a hidden placeholder (spaces, unknown characters) kept so alignment can count it
+// char_index is -1 for spaces, which don't get colored or shaded
+void SpriteText::add_glyph(const SpriteTextLayout::Glyph& g, ReferenceRect* scr)
+{
+	glyphs.push_back({ g.line, g.col });
+	int idx = int(glyphs.size()) - 1;
+	if (alignment != ALIGN::LEFT && g.char_index >= 0 && align_from < 0)
+		align_from = idx;
+	SpriteFont* c = cast_to<SpriteFont>(font_res->instance());
+	if (g.frame >= 0)
+		c->set_frame(g.frame);
 	else
+		c->hide();
+	if (g.char_index >= 0)
 	{
-		SpriteFont* c = cast_to<SpriteFont>(font_res->instance());
-		// Are we trying to parse a control hint?
-		if (text[i] == L'$' && text[i + 1] == L'c')
-		{
-			c->set_frame(int(Math::clamp(int(text[i + 2]) * 10 + int(text[i + 3]), 0, 48)));
-			write_progress += 3;
-		}
-		// Find the correct character in our text texture
-		else
-		{
-			int frame = c->get_character_set().find(text[i]);
-			if (frame >= 0)
-				c->set_frame(Math::min(frame, int(c->get_hframes() * c->get_vframes())));
-			else
-				c->hide();
-		};
 		// Colorize the character
 		c->set_modulate(font_color);
-		// Obvious
-		c->set_scale(font_scale);
 		// We can apply a custom shader to the individual characters
 		if (font_shader != "")
 		{
 			c->set_material(font_shader_res->duplicate());
-			Ref<ShaderMaterial>((c)->get_material())->set_shader_param("char_index", i);
-		};
-		// Add the character to the tree
-		scr->add_child(c);
-		// Positioning is complicated, huh?
-		if (float(px) * fx >= get_size().x)
-		{
-			py += 1;
-			px = 0;
-		};
-		c->set_position(Vector2(px * fx, py * fy));
-		if (alignment != ALIGN::LEFT)
-		{
-			int t_ct = int(scr->get_child_count()) - 1;
-			for (int j = 0; j < px + 1; j++)
-			{
-				if (t_ct - j >= 0)
-				{
-					SpriteFont* align_c = cast_to<SpriteFont>(scr->get_child(t_ct - j));
-					float x;
-					if (alignment == ALIGN::CENTER)
-					{
-						x = scr->get_size().x * 0.5f + px * 0.5f * fx;
-						x -= fx * j;
-					}
-					else if (alignment == ALIGN::RIGHT)
-					{
-						x = scr->get_size().x - fx + text_margin.x;
-						x -= fx * j;
-					}
-					align_c->set_position(Vector2(x, py * fy));
-				};
-			};
+			Ref<ShaderMaterial>((c)->get_material())->set_shader_param("char_index", g.char_index);
 		};
-		px += 1;
 	};
-	scr->set_size(Vector2(scr->get_size().x, float(py + 1) * fy + 1.0f));
-	write_pos = Vector2(px, py);
+	// Obvious
+	c->set_scale(font_scale);
+	// Add the character to the tree
+	scr->add_child(c);
+	c->set_owner(scr);
+	c->set_position(get_glyph_position(idx, scr));
+}
+
+float SpriteText::get_line_offset(int line, ReferenceRect* scr)
+{
+	float fx = font_size.x * font_scale.x + text_margin.x;
+	int last = layout.get_last_col(line);
+	if (alignment == ALIGN::CENTER)
+		return scr->get_size().x * 0.5f - last * 0.5f * fx;
+	if (alignment == ALIGN::RIGHT)
+		return scr->get_size().x - fx + text_margin.x - last * fx;
+	return 0.0f;
+}
+
+Vector2 SpriteText::get_glyph_position(int idx, ReferenceRect* scr)
+{
+	float fx = font_size.x * font_scale.x + text_margin.x, fy = font_size.y * font_scale.y + text_margin.y;
+	const Glyph& g = glyphs[idx];
+	return Vector2(get_line_offset(g.line, scr) + g.col * fx, g.line * fy);
+}
+
+// Centered and right aligned lines shift as they grow; move everything from the start of the
+// first line touched since the last call, once, instead of after every character
+void SpriteText::align_glyphs(ReferenceRect* scr)
+{
+	if (align_from < 0)
+		return;
+	int start = Math::min(align_from, int(glyphs.size()));
+	align_from = -1;
+	if (start == glyphs.size())
+		return;
+	while (start > 0 && glyphs[start - 1].line == glyphs[start].line)
+		start--;
+	for (int i = start; i < glyphs.size(); i++)
+		cast_to<SpriteFont>(scr->get_child(i))->set_position(get_glyph_position(i, scr));
+}
+
+void SpriteText::trim_glyphs(ReferenceRect* scr)
+{
+	if (glyphs.size() <= MAX_CHARS)
+		return;
+	int excess = int(glyphs.size()) - MAX_CHARS;
+	glyphs.erase(glyphs.begin(), glyphs.begin() + excess);
+	if (align_from >= 0)
+		align_from = Math::max(align_from - excess, 0);
+	for (int i = 0; i < excess && scr->get_child_count() > 0; i++)
+	{
+		Node* c = scr->get_child(0);
+		scr->remove_child(c);
+		c->queue_free();
+	};
 }
 
 // BASE PROCESSING -----------------------------------------------------------------
@@ -15,6 +15,26 @@ SPRITE FONT CLASS ============================================================
 Definition object instanced by Sprite Text objects.Setting character size and
 character set will automatically cut the frames appropriately.
 *******************************************************************************/
+// Codepoint to frame lookup; ASCII is a straight array, everything else a sorted table
+struct SpriteCharMap
+{
+	int ascii[128];
+	std::vector<std::pair<wchar_t, int>> others;
+	SpriteCharMap();
+	void build(String character_set);
+	int find(wchar_t c) const;
+};
+
+// Everything SpriteText needs from a font scene without instancing it
+struct SpriteFontMetrics
+{
+	Ref<PackedScene> scene;
+	Vector2 character_size = Vector2(8.0f, 8.0f);
+	int hframes = 1, vframes = 1;
+	String character_set = "";
+	SpriteCharMap char_map;
+};
+
 class SpriteFont : public Sprite
 {
 	GODOT_CLASS(SpriteFont, Sprite);
@@ -22,12 +42,55 @@ private:
 	Vector2 character_size = Vector2(8.0f, 8.0f);
 	String character_set = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789., !? '\":()+-*/=@#$_";
 public:
+	SpriteCharMap char_map;
 	static void _register_methods();
 	void set_character_size(Vector2 new_size);
 	Vector2 get_character_size();
 	void set_character_set(String new_character_set);
 	String get_character_set();
 	void _init();
+	// Fonts are instanced once per path and remembered for the rest of the run; null if it isn't a SpriteFont scene
+	static const SpriteFontMetrics* get_metrics(String path);
+	// Call from godot_gdnative_terminate, while the engine is still up to release the scenes (see readme.md)
+	static void clear_metrics();
+};
+
+/*******************************************************************************
+SPRITE TEXT LAYOUT CLASS =====================================================
+Works out where each glyph of a text goes without touching any nodes. The text is
+scanned once up front for word lengths, then laid out one character per step, so
+typewriter writing only ever lays out what has just been revealed.
+*******************************************************************************/
+class SpriteTextLayout
+{
+public:
+	struct Glyph
+	{
+		int char_index;	// -1 for spaces
+		int frame;		// -1 for hidden placeholders
+		int line, col;
+	};
+	struct Step
+	{
+		bool has_glyph, is_space;
+		Glyph glyph;
+	};
+	// Settings, picked up by set_text
+	float box_width = 0.0f, advance = 8.0f;
+	bool word_wrap = true;
+	const SpriteCharMap* char_map = nullptr;
+	int frame_count = 0;
+	// Cursor; carries over between texts until cleared
+	int px = 0, py = 0;
+	void clear();
+	void set_text(String new_text);
+	bool is_done() const;
+	bool step(Step& s);
+	int get_last_col(int line) const;
+private:
+	String text = "";
+	int pos = 0;
+	std::vector<int> next_space, next_newline, last_col;
 };
 
 /*******************************************************************************
@@ -52,6 +115,7 @@ public:
 	int font_index = 0;
 	std::vector<String> font_sources;
 	Ref<PackedScene> font_res;
+	const SpriteFontMetrics* font_metrics = nullptr;
 	Vector2 font_scale = Vector2::ONE, font_size = Vector2(8.0f, 8.0f);
 	Color font_color = Color(1.0f, 1.0f, 1.0f, 1.0f);
 	String font_shader = "";
@@ -64,9 +128,13 @@ public:
 	bool word_wrap = true, auto_scroll = true;
 	Vector2 text_margin = Vector2(0.0f, 2.0f);
 	// Writing Handler
-	int write_progress = 0, next_word_length = 0;
+	SpriteTextLayout layout;
+	bool write_finished = true;
 	float write_ct = 0.0f;
-	Vector2 write_pos = Vector2::ZERO;
+	// Where each character went, in the same order as the scroll node's children
+	struct Glyph { int line, col; };
+	std::vector<Glyph> glyphs;
+	int align_from = -1;
 	// METHODS -----------------------------------------------------
 	// Godot
 	static void _register_methods();
@@ -104,7 +172,12 @@ public:
 	void clear();
 	void write(String new_text, bool clear_text = true);
 	void write_loop(float delta, ReferenceRect* scr);
-	void write_char(int i);
+	bool write_step(ReferenceRect* scr);
+	void add_glyph(const SpriteTextLayout::Glyph& g, ReferenceRect* scr);
+	float get_line_offset(int line, ReferenceRect* scr);
+	Vector2 get_glyph_position(int idx, ReferenceRect* scr);
+	void align_glyphs(ReferenceRect* scr);
+	void trim_glyphs(ReferenceRect* scr);
 	// Base Processing
 	void _init();
 	void _ready();
@@ -1,6 +1,8 @@
 #include "SpriteText.h"
 #include <godot_cpp/classes/resource_loader.hpp>
 #include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <algorithm>
 #include <godot_cpp/variant/utility_functions.hpp>
 
 using namespace godot;
@@ -26,14 +28,194 @@ void SpriteFont::_bind_methods() {
 
 void SpriteFont::set_character_size(Vector2 new_character_size) { character_size = new_character_size; }
 Vector2 SpriteFont::get_character_size() { return character_size; }
-void SpriteFont::set_character_set(String new_character_set) { character_set = new_character_set; }
+void SpriteFont::set_character_set(String new_character_set) {
+    character_set = new_character_set;
+    char_map.build(character_set);
+}
 String SpriteFont::get_character_set() { return character_set; }
 
-SpriteFont::SpriteFont() {}
+// Entries are never moved once inserted, so SpriteTexts can point straight at them
+static HashMap<String, SpriteFontMetrics> metrics_cache;
+
+const SpriteFontMetrics* SpriteFont::get_metrics(const String& path) {
+    // The editor reloads every time so font changes show up; the entry is refreshed in place
+    bool editor = Engine::get_singleton()->is_editor_hint();
+    if (!editor) {
+        const SpriteFontMetrics* cached = metrics_cache.getptr(path);
+        if (cached != nullptr)
+            return cached;
+    }
+    if (!FileAccess::file_exists(path))
+        return nullptr;
+    Ref<PackedScene> scene = ResourceLoader::get_singleton()->load(path);
+    if (!scene.is_valid())
+        return nullptr;
+    Node* n = scene->instantiate();
+    SpriteFont* c = cast_to<SpriteFont>(n);
+    if (c == nullptr) {
+        if (n != nullptr)
+            n->queue_free();
+        return nullptr;
+    }
+    SpriteFontMetrics& m = metrics_cache[path];
+    m.scene = scene;
+    m.texture = c->get_texture();
+    m.character_size = c->character_size;
+    m.offset = c->get_offset();
+    m.hframes = c->get_hframes();
+    m.vframes = c->get_vframes();
+    m.centered = c->is_centered();
+    m.character_set = c->character_set;
+    m.char_map = c->char_map;
+    c->queue_free();
+    return &m;
+}
+
+// The cache holds scene and texture references, which have to go before the engine does
+void SpriteFont::clear_metrics() { metrics_cache.clear(); }
+
+SpriteFont::SpriteFont() { char_map.build(character_set); }
+
+SpriteCharMap::SpriteCharMap() {
+    for (int i = 0; i < 128; i++)
+        ascii[i] = -1;
+}
+
+// Duplicates keep their first frame, same as searching the set would
+void SpriteCharMap::build(const String& character_set) {
+    for (int i = 0; i < 128; i++)
+        ascii[i] = -1;
+    others.clear();
+    for (int i = 0; i < character_set.length(); i++) {
+        char32_t c = character_set[i];
+        if (c < 128) {
+            if (ascii[c] < 0)
+                ascii[c] = i;
+        }
+        else
+            others.push_back(std::make_pair(c, i));
+    }
+    std::stable_sort(others.begin(), others.end(), [](const std::pair<char32_t, int>& a, const std::pair<char32_t, int>& b) { return a.first < b.first; });
+    others.erase(std::unique(others.begin(), others.end(), [](const std::pair<char32_t, int>& a, const std::pair<char32_t, int>& b) { return a.first == b.first; }), others.end());
+}
+
+int SpriteCharMap::find(char32_t c) const {
+    if (c < 128)
+        return ascii[c];
+    std::vector<std::pair<char32_t, int>>::const_iterator itr = std::lower_bound(others.begin(), others.end(), std::make_pair(c, -1));
+    if (itr != others.end() && itr->first == c)
+        return itr->second;
+    return -1;
+}
 SpriteFont::~SpriteFont() {}
 
 /*******************************************************************************
 
+SPRITE TEXT LAYOUT CLASS
+
+Works out where each glyph of a text goes without touching any nodes. The text is
+scanned once up front for word lengths, then laid out one character per step, so
+typewriter writing only ever lays out what has just been revealed.
+
+*******************************************************************************/
+void SpriteTextLayout::clear() {
+    px = 0;
+    py = 0;
+    last_col.clear();
+    set_text(String());
+}
+
+// One backwards pass finds the next space and newline after every character,
+// which is all the word wrap ever needs to know
+void SpriteTextLayout::set_text(const String& new_text) {
+    text = new_text;
+    pos = 0;
+    int len = text.length();
+    next_space.resize(len + 1);
+    next_newline.resize(len + 1);
+    next_space[len] = -1;
+    next_newline[len] = -1;
+    for (int i = len - 1; i >= 0; i--) {
+        next_space[i] = (text[i] == U' ') ? i : next_space[i + 1];
+        next_newline[i] = (text[i] == U'\n') ? i : next_newline[i + 1];
+    }
+}
+
+bool SpriteTextLayout::is_done() const { return pos >= text.length(); }
+
+int SpriteTextLayout::get_last_col(int line) const {
+    if (line < 0 || line >= last_col.size())
+        return -1;
+    return last_col[line];
+}
+
+bool SpriteTextLayout::step(Step& s) {
+    int len = text.length();
+    if (pos >= len)
+        return false;
+    int i = pos;
+    pos++;
+    s.has_glyph = false;
+    s.is_space = false;
+    // Newline
+    if (text[i] == U'\n') {
+        py += 1;
+        px = 0;
+    }
+    else if (text[i] == U'\\' && i + 1 < len && text[i + 1] == U'n') {
+        py += 1;
+        px = 0;
+        pos++;
+    }
+    // Space
+    else if (text[i] == U' ') {
+        s.is_space = true;
+        px += 1;
+        if (word_wrap) {
+            int next_word_length = (next_space[i + 1] < 0) ? len - i - 1 : next_space[i + 1] - i - 1;
+            // We only wrap if we don't find a newline in the middle of our word
+            int nl = next_newline[i + 1];
+            if (nl == -1 || nl > i + next_word_length - 2)
+                if ((px + next_word_length) * advance >= box_width) {
+                    py += 1;
+                    px = 0;
+                }
+        }
+        if (px > 0) {
+            s.has_glyph = true;
+            s.glyph = { -1, -1, py, px };
+        }
+    }
+    // Standard character
+    else {
+        int frame;
+        // Are we trying to parse a control hint?
+        if (text[i] == U'$' && i + 3 < len && text[i + 1] == U'c') {
+            frame = int(Math::clamp(int(text[i + 2]) * 10 + int(text[i + 3]), 0, 48));
+            pos += 3;
+        }
+        // Find the correct character in our text texture
+        else {
+            frame = (char_map != nullptr) ? char_map->find(text[i]) : -1;
+            if (frame >= 0)
+                frame = Math::min(frame, frame_count);
+        }
+        if (float(px) * advance >= box_width) {
+            py += 1;
+            px = 0;
+        }
+        s.has_glyph = true;
+        s.glyph = { i, frame, py, px };
+        if (last_col.size() <= py)
+            last_col.resize(py + 1, -1);
+        last_col[py] = px;
+        px += 1;
+    }
+    return true;
+}
+
+/*******************************************************************************
+
 SPRITE TEXT CLASS
 
 ReferenceRect node that writes and displays text. It creates a child ReferenceRect
@@ -90,11 +272,25 @@ void SpriteText::_bind_methods() {
     ClassDB::bind_method(D_METHOD("set_scroll_speed", "_scroll_speed"), &SpriteText::set_scroll_speed);
     ClassDB::bind_method(D_METHOD("get_scroll_speed"), &SpriteText::get_scroll_speed);
     ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "scroll_speed"), "set_scroll_speed", "get_scroll_speed");
+    // batch mode
+    ClassDB::bind_method(D_METHOD("set_batch_mode", "_batch_mode"), &SpriteText::set_batch_mode);
+    ClassDB::bind_method(D_METHOD("get_batch_mode"), &SpriteText::get_batch_mode);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "batch_mode"), "set_batch_mode", "get_batch_mode");
+    // console mode
+    ClassDB::bind_method(D_METHOD("set_console_mode", "_console_mode"), &SpriteText::set_console_mode);
+    ClassDB::bind_method(D_METHOD("get_console_mode"), &SpriteText::get_console_mode);
+    ADD_PROPERTY(PropertyInfo(Variant::BOOL, "console_mode"), "set_console_mode", "get_console_mode");
+    // console capacity
+    ClassDB::bind_method(D_METHOD("set_console_capacity", "_console_capacity"), &SpriteText::set_console_capacity);
+    ClassDB::bind_method(D_METHOD("get_console_capacity"), &SpriteText::get_console_capacity);
+    ADD_PROPERTY(PropertyInfo(Variant::INT, "console_capacity"), "set_console_capacity", "get_console_capacity");
 
     // METHODS
     ClassDB::bind_method(D_METHOD("add_scroll_box"), &SpriteText::add_scroll_box);
     ClassDB::bind_method(D_METHOD("clear"), &SpriteText::clear);
     ClassDB::bind_method(D_METHOD("write", "new_text", "clear_old_text"), &SpriteText::write);
+    ClassDB::bind_method(D_METHOD("console_print", "line"), &SpriteText::console_print);
+    ClassDB::bind_method(D_METHOD("console_clear"), &SpriteText::console_clear);
 
     // SIGNALS
     ADD_SIGNAL(MethodInfo("write_complete"));
@@ -121,13 +317,12 @@ String SpriteText::get_font() { return font_path; }
 bool SpriteText::set_font_res() {
     if (font_path == "")
         return false;
-    Ref<FileAccess> file = nullptr;
-    if (!file->file_exists(font_path))
+    const SpriteFontMetrics* metrics = SpriteFont::get_metrics(font_path);
+    if (metrics == nullptr)
         return false;
-    font_res = ResourceLoader::get_singleton()->load(font_path);
-    SpriteFont* c = cast_to<SpriteFont>(font_res->instantiate());
-    font_size = c->character_size;
-    c->queue_free();
+    font_metrics = metrics;
+    font_res = font_metrics->scene;
+    font_size = font_metrics->character_size;
     return true;
 }
 
@@ -165,6 +360,42 @@ void SpriteText::set_text_margin(Vector2 new_margin) { text_margin = new_margin;
 void SpriteText::set_auto_scroll(bool is_auto_scroll) { auto_scroll = is_auto_scroll; } bool SpriteText::get_auto_scroll() { return auto_scroll; }
 void SpriteText::set_scroll_speed(float new_scroll_speed) { scroll_speed = new_scroll_speed; } float SpriteText::get_scroll_speed() { return scroll_speed; }
 
+void SpriteText::set_batch_mode(bool is_batch_mode) {
+    if (batch_mode == is_batch_mode)
+        return;
+    batch_mode = is_batch_mode;
+    // Sprite nodes take over; the quads left on the glyph canvas would otherwise sit under them
+    if (!batch_mode && glyph_canvas.is_valid())
+        RenderingServer::get_singleton()->canvas_item_clear(glyph_canvas);
+    write(text);
+}
+bool SpriteText::get_batch_mode() { return batch_mode; }
+
+void SpriteText::set_console_mode(bool is_console_mode) {
+    if (console_mode == is_console_mode)
+        return;
+    console_mode = is_console_mode;
+    clear();
+    console_dirty = console_mode;
+}
+bool SpriteText::get_console_mode() { return console_mode; }
+
+// Keeps the newest lines that still fit
+void SpriteText::set_console_capacity(int new_capacity) {
+    new_capacity = Math::max(new_capacity, 1);
+    std::vector<String> lines;
+    int keep = Math::min(console_count, new_capacity);
+    for (int i = console_count - keep; i < console_count; i++)
+        lines.push_back(console_lines[(console_head + i) % console_capacity]);
+    lines.resize(new_capacity);
+    console_lines.swap(lines);
+    console_capacity = new_capacity;
+    console_head = 0;
+    console_count = keep;
+    console_dirty = console_mode;
+}
+int SpriteText::get_console_capacity() { return console_capacity; }
+
 // Need to call this as a separate deferred function to make it work right
 void SpriteText::add_scroll_box() {
     scr = new ReferenceRect;
@@ -183,12 +414,17 @@ void SpriteText::clear() {
         return;
     if (scr == nullptr)
         return;
-    while (scr->get_child_count() > 0) {
-        scr->get_child(0)->queue_free();
-        scr->remove_child(scr->get_child(0));
+    // From the back, so the child list never has to shuffle down
+    for (int i = scr->get_child_count() - 1; i >= 0; i--) {
+        Node* c = scr->get_child(i);
+        scr->remove_child(c);
+        c->queue_free();
     }
+    glyphs.clear();
+    glyphs_dirty = batch_mode;
+    align_from = -1;
+    layout.clear();
     text = String();
-    write_pos = Vector2();
     scr->set_size(Vector2(scr->get_size().x, font_size.y));
     scr->set_position(Vector2());
 }
@@ -205,7 +441,13 @@ void SpriteText::write(String new_text, bool clear_text) {
         return;
     }
     text = new_text;
-    write_progress = 0;
+    layout.box_width = get_size().x;
+    layout.advance = font_size.x * font_scale.x + text_margin.x;
+    layout.word_wrap = word_wrap;
+    layout.char_map = &font_metrics->char_map;
+    layout.frame_count = font_metrics->hframes * font_metrics->vframes;
+    layout.set_text(text);
+    write_finished = false;
     write_ct = 0.0f;
     write_loop(get_process_delta_time());
 }
@@ -215,144 +457,253 @@ void SpriteText::write_loop(float delta) {
         return;
 
     // Writing
-    if (write_progress < text.length()) {
+    bool wrote = false;
+    if (!layout.is_done()) {
         // Instant gratification
         if (write_speed < 0.0f) {
-            for (int i = 0; i < text.length() - write_progress; i++)
-                if (is_inside_tree())
-                    write_char(i + write_progress);
-            write_progress = text.length();
+            if (is_inside_tree())
+                while (write_step());
+            wrote = true;
         }
         // Typewriter effect
         else {
             if (write_ct <= 0)
             {
                 write_ct = write_speed;
-                write_char(write_progress);
-                write_progress++;
+                write_step();
+                wrote = true;
             }
             else
                 write_ct -= delta;
         }
     }
+    if (wrote) {
+        align_glyphs();
+        float fy = font_size.y * font_scale.y + text_margin.y;
+        scr->set_size(Vector2(scr->get_size().x, float(layout.py + 1) * fy + 1.0f));
+    }
 
     // Finish writing
-    if (write_progress == text.length()) {
-        write_progress++;
+    if (layout.is_done() && !write_finished) {
+        write_finished = true;
         emit_signal("write_complete");
     }
-    if (scr->get_child_count() > MAX_CHARS)
-        scr->get_child(0)->queue_free();
+    trim_glyphs();
 }
 
-void SpriteText::write_char(int i) {
-    if (scr == nullptr)
-        return;
-    if (!font_res.is_valid())
-        return;
-    if (i >= text.length())
-        return;
-    float px = write_pos.x, py = write_pos.y;
-    float fx = font_size.x * font_scale.x + text_margin.x, fy = font_size.y * font_scale.y + text_margin.y;
-    // Create the character
-    // Newline
-    if (text[i] == L'\n') {
-        py += 1;
-        px = 0;
-    }
-    else if (text[i] == L'\\' && text[i + 1] == L'n') {
-        py += 1;
-        px = 0;
-        write_progress++;
-    }
-    // Space
-    else if (text[i] == L' ') {
+// Returns false once there's nothing left to write
+bool SpriteText::write_step() {
+    SpriteTextLayout::Step s;
+    if (!layout.step(s))
+        return false;
+    // Spaces don't hold up the typewriter
+    if (s.is_space)
         write_ct = 0.0f;
-        px += 1;
-        if (word_wrap) {
-            if (text.find(" ", i + 1) < 0)
-                next_word_length = text.length() - i - 1;
-            else
-                next_word_length = text.find(" ", i + 1) - i - 1;
-            // We only wrap if we don't find a newline in the middle of our word
-            if (text.find("\n", i + 1) == -1 || text.find("\n", i + 1) > i + next_word_length - 2)
-                if ((px + next_word_length) * fx >= get_size().x) {
-                    py += 1;
-                    px = 0;
-                }
-        }
-        if (px > 0) {
-            SpriteFont* c = cast_to<SpriteFont>(font_res->instantiate());
-            c->hide();
-            c->set_scale(font_scale);
-            scr->add_child(c);
-            c->set_owner(scr);
-            c->set_position(Vector2(px * fx, py * fy));
-        }
+    if (s.has_glyph)
+        add_glyph(s.glyph);
+    return true;
+}
+
+// Frame -1 is a hidden placeholder (spaces, unknown characters) kept so alignment can count it
+// char_index is -1 for spaces, which don't get colored or shaded
+// Both modes keep the glyph record, since sprite nodes are placed from it; only batch mode draws it
+void SpriteText::add_glyph(const SpriteTextLayout::Glyph& g) {
+    glyphs.push_back({ g.line, g.col, g.frame, font_color });
+    int idx = int(glyphs.size()) - 1;
+    if (alignment != ALIGN::LEFT && g.char_index >= 0 && align_from < 0)
+        align_from = idx;
+    if (batch_mode) {
+        glyphs_dirty = true;
+        return;
     }
-    // Standard character
-    else {
-        SpriteFont* c = cast_to<SpriteFont>(font_res->instantiate());
-        // Are we trying to parse a control hint?
-        if (text[i] == L'$' && text[i + 1] == L'c') {
-            c->set_frame(int(Math::clamp(int(text[i + 2]) * 10 + int(text[i + 3]), 0, 48)));
-            write_progress += 3;
-        }
-        // Find the correct character in our text texture
-        else {
-            int frame = c->get_character_set().find(String(&text[i]).left(1), 0);
-            if (frame >= 0)
-                c->set_frame(Math::min(frame, int(c->get_hframes() * c->get_vframes())));
-            else
-                c->hide();
-        }
+    // Console redraws leave their old characters behind to be reused
+    SpriteFont* c;
+    bool recycled = idx < scr->get_child_count();
+    if (recycled)
+        c = cast_to<SpriteFont>(scr->get_child(idx));
+    else
+        c = cast_to<SpriteFont>(font_res->instantiate());
+    c->set_visible(g.frame >= 0);
+    if (g.frame >= 0)
+        c->set_frame(g.frame);
+    if (g.char_index >= 0) {
         // Colorize the character
         c->set_modulate(font_color);
-        // Obvious
-        c->set_scale(font_scale);
         // We can apply a custom shader to the individual characters
         if (font_shader != "") {
             //c->set_material(font_shader_res->duplicate());
-            Ref<ShaderMaterial>((c)->get_material())->set_shader_parameter("char_index", i);
+            Ref<ShaderMaterial>((c)->get_material())->set_shader_parameter("char_index", g.char_index);
         }
-        // Add the character to the tree
+    }
+    // Obvious
+    c->set_scale(font_scale);
+    // Add the character to the tree
+    if (!recycled) {
         scr->add_child(c);
         c->set_owner(scr);
-        // Positioning is complicated, huh?
-        if (float(px) * fx >= get_size().x) {
-            py += 1;
-            px = 0;
-        }
-        c->set_position(Vector2(px * fx, py * fy));
-        if (alignment != ALIGN::LEFT) {
-            int t_ct = int(scr->get_child_count()) - 1;
-            for (int j = 0; j < px + 1; j++) {
-                if (t_ct - j >= 0) {
-                    SpriteFont* align_c = cast_to<SpriteFont>(scr->get_child(t_ct - j));
-                    float x = 0.0f;
-                    if (alignment == ALIGN::CENTER) {
-                        x = scr->get_size().x * 0.5f + px * 0.5f * fx;
-                        x -= fx * j;
-                    }
-                    else if (alignment == ALIGN::RIGHT) {
-                        x = scr->get_size().x - fx + text_margin.x;
-                        x -= fx * j;
-                    }
-                    align_c->set_position(Vector2(x, py * fy));
-                }
-            }
-        }
-        px += 1;
     }
-    scr->set_size(Vector2(scr->get_size().x, float(py + 1) * fy + 1.0f));
-    write_pos = Vector2(px, py);
+    c->set_position(get_glyph_position(idx));
+}
+
+float SpriteText::get_line_offset(int line) {
+    float fx = font_size.x * font_scale.x + text_margin.x;
+    int last = layout.get_last_col(line);
+    if (alignment == ALIGN::CENTER)
+        return scr->get_size().x * 0.5f - last * 0.5f * fx;
+    if (alignment == ALIGN::RIGHT)
+        return scr->get_size().x - fx + text_margin.x - last * fx;
+    return 0.0f;
+}
+
+Vector2 SpriteText::get_glyph_position(int idx) {
+    float fx = font_size.x * font_scale.x + text_margin.x, fy = font_size.y * font_scale.y + text_margin.y;
+    const Glyph& g = glyphs[idx];
+    return Vector2(get_line_offset(g.line) + g.col * fx, g.line * fy);
+}
+
+// Centered and right aligned lines shift as they grow; move everything from the start of the
+// first line touched since the last call, once, instead of after every character
+void SpriteText::align_glyphs() {
+    if (align_from < 0)
+        return;
+    int start = Math::min(align_from, int(glyphs.size()));
+    align_from = -1;
+    if (start == glyphs.size())
+        return;
+    while (start > 0 && glyphs[start - 1].line == glyphs[start].line)
+        start--;
+    if (batch_mode) {
+        glyphs_dirty = true;
+        return;
+    }
+    for (int i = start; i < glyphs.size(); i++)
+        cast_to<SpriteFont>(scr->get_child(i))->set_position(get_glyph_position(i));
+}
+
+void SpriteText::trim_glyphs() {
+    if (console_mode || glyphs.size() <= MAX_CHARS)
+        return;
+    int excess = int(glyphs.size()) - MAX_CHARS;
+    glyphs.erase(glyphs.begin(), glyphs.begin() + excess);
+    if (align_from >= 0)
+        align_from = Math::max(align_from - excess, 0);
+    if (batch_mode) {
+        glyphs_dirty = true;
+        return;
+    }
+    for (int i = 0; i < excess && scr->get_child_count() > 0; i++) {
+        Node* c = scr->get_child(0);
+        scr->remove_child(c);
+        c->queue_free();
+    }
+}
+
+// Rebuilds the glyph canvas item in one go; it's a child of the scroll node so it scrolls and clips with it
+void SpriteText::draw_glyphs() {
+    if (!batch_mode || !glyphs_dirty || scr == nullptr)
+        return;
+    glyphs_dirty = false;
+    RenderingServer* rs = RenderingServer::get_singleton();
+    if (!glyph_canvas.is_valid()) {
+        glyph_canvas = rs->canvas_item_create();
+        rs->canvas_item_set_parent(glyph_canvas, scr->get_canvas_item());
+    }
+    rs->canvas_item_clear(glyph_canvas);
+    if (font_shader_res.is_valid())
+        rs->canvas_item_set_material(glyph_canvas, font_shader_res->get_rid());
+    if (font_metrics == nullptr || !font_metrics->texture.is_valid() || font_metrics->hframes <= 0 || font_metrics->vframes <= 0)
+        return;
+    Vector2 frame_size = font_metrics->texture->get_size() / Vector2(font_metrics->hframes, font_metrics->vframes);
+    Vector2 origin = font_metrics->offset;
+    if (font_metrics->centered)
+        origin -= frame_size * 0.5f;
+    RID tex = font_metrics->texture->get_rid();
+    for (int i = 0; i < glyphs.size(); i++) {
+        const Glyph& g = glyphs[i];
+        if (g.frame < 0 || g.frame >= font_metrics->hframes * font_metrics->vframes)
+            continue;
+        Rect2 src = Rect2(Vector2(g.frame % font_metrics->hframes, g.frame / font_metrics->hframes) * frame_size, frame_size);
+        rs->canvas_item_add_texture_rect_region(glyph_canvas, Rect2(get_glyph_position(i) + origin * font_scale, frame_size * font_scale), tex, src, g.color);
+    }
+}
+
+/*****************************************************
+CONSOLE
+*****************************************************/
+// Cheap enough to call for every log line; nothing is laid out until the next frame
+void SpriteText::console_print(String line) {
+    if (console_lines.size() != console_capacity)
+        console_lines.resize(console_capacity);
+    // Once full, the oldest line's slot is the one that gets reused
+    int slot = (console_head + console_count) % console_capacity;
+    if (console_count < console_capacity)
+        console_count++;
+    else
+        console_head = (console_head + 1) % console_capacity;
+    console_lines[slot] = line;
+    console_dirty = true;
+}
+
+void SpriteText::console_clear() {
+    console_head = 0;
+    console_count = 0;
+    console_dirty = true;
+}
+
+// Lays out only the newest lines that fit in the box
+void SpriteText::console_refresh() {
+    if (!console_dirty || scr == nullptr)
+        return;
+    console_dirty = false;
+    if (!set_font_res())
+        return;
+    float fx = font_size.x * font_scale.x + text_margin.x, fy = font_size.y * font_scale.y + text_margin.y;
+    int rows_visible = Math::max(int(get_size().y / fy), 1);
+    layout.box_width = get_size().x;
+    layout.advance = fx;
+    layout.word_wrap = word_wrap;
+    layout.char_map = &font_metrics->char_map;
+    layout.frame_count = font_metrics->hframes * font_metrics->vframes;
+    // Count rows back from the newest line until the box is full
+    SpriteTextLayout counter = layout;
+    SpriteTextLayout::Step st;
+    int rows = 0, first = console_count;
+    while (first > 0 && rows < rows_visible) {
+        first--;
+        counter.clear();
+        counter.set_text(console_lines[(console_head + first) % console_capacity]);
+        while (counter.step(st));
+        rows += counter.py + 1;
+    }
+    text = String();
+    for (int i = first; i < console_count; i++) {
+        if (i > first)
+            text += "\n";
+        text += console_lines[(console_head + i) % console_capacity];
+    }
+    glyphs.clear();
+    align_from = -1;
+    layout.clear();
+    layout.set_text(text);
+    while (write_step());
+    align_glyphs();
+    // Anything left over from a longer redraw waits, hidden, for the next one
+    for (int i = int(glyphs.size()); i < scr->get_child_count(); i++)
+        cast_to<CanvasItem>(scr->get_child(i))->hide();
+    glyphs_dirty = batch_mode;
+    write_finished = true;
+    scr->set_size(Vector2(scr->get_size().x, float(layout.py + 1) * fy + 1.0f));
+    scr->set_position(Vector2(scr->get_position().x, Math::min(get_size().y - scr->get_size().y, 0.0f)));
 }
 
 /*****************************************************
 BASE PROCESSING
 *****************************************************/
 SpriteText::SpriteText() {}
-SpriteText::~SpriteText() {}
+SpriteText::~SpriteText() {
+    if (glyph_canvas.is_valid())
+        RenderingServer::get_singleton()->free_rid(glyph_canvas);
+}
 
 void SpriteText::ready() {
     set_clip_contents(true);
@@ -379,6 +730,9 @@ void SpriteText::process(float delta) {
 
     // Writing
     write_loop(delta);
+    if (console_mode)
+        console_refresh();
+    draw_glyphs();
 
     // Scrolling
     scr->set_size(Vector2(get_size().x, scr->get_size().y));
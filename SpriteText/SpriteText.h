@@ -16,6 +16,8 @@ GODOT BINDINGS
 #include <godot_cpp/classes/scene_tree.hpp>
 
 #include <godot_cpp/classes/texture.hpp>
+#include <godot_cpp/classes/texture2d.hpp>
+#include <godot_cpp/classes/rendering_server.hpp>
 #include <godot_cpp/classes/sprite2d.hpp>
 #include <godot_cpp/classes/shader_material.hpp>
 #include <godot_cpp/classes/reference_rect.hpp>
@@ -29,6 +31,26 @@ namespace godot {
     Setting character size and character set will automatically cut the frames appropriately.
 
     *******************************************************************************/
+    // Codepoint to frame lookup; ASCII is a straight array, everything else a sorted table
+    struct SpriteCharMap {
+        int ascii[128];
+        std::vector<std::pair<char32_t, int>> others;
+        SpriteCharMap();
+        void build(const String& character_set);
+        int find(char32_t c) const;
+    };
+
+    // Everything SpriteText needs from a font scene without instancing it
+    struct SpriteFontMetrics {
+        Ref<PackedScene> scene;
+        Ref<Texture2D> texture;
+        Vector2 character_size = Vector2(8.0f, 8.0f), offset = Vector2();
+        int hframes = 1, vframes = 1;
+        bool centered = false;
+        String character_set = String();
+        SpriteCharMap char_map;
+    };
+
     class SpriteFont : public Sprite2D {
         GDCLASS(SpriteFont, Sprite2D)
     protected:
@@ -36,12 +58,59 @@ namespace godot {
     public:
         Vector2 character_size = Vector2(8.0f, 8.0f);
         String character_set = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789., !? '\":()+-*/=@#$_";
+        SpriteCharMap char_map;
         SpriteFont();
         ~SpriteFont();
         void set_character_size(Vector2 new_size);
         Vector2 get_character_size();
         void set_character_set(String new_character_set);
         String get_character_set();
+        // Fonts are instanced once per path and remembered for the rest of the run (except in the editor);
+        // null if the path isn't a SpriteFont scene
+        static const SpriteFontMetrics* get_metrics(const String& path);
+        // Call from the module's uninitialize, before the engine releases resources (see readme.md)
+        static void clear_metrics();
+    };
+
+    /*******************************************************************************
+
+    SPRITE TEXT LAYOUT CLASS
+
+    Works out where each glyph of a text goes without touching any nodes. The text is
+    scanned once up front for word lengths, then laid out one character per step, so
+    typewriter writing only ever lays out what has just been revealed.
+    Glyphs are placed by line and column; alignment offsets come from each line's
+    last column, which is all the line metrics there are to keep.
+
+    *******************************************************************************/
+    class SpriteTextLayout {
+    public:
+        struct Glyph {
+            int char_index;     // -1 for spaces
+            int frame;          // -1 for hidden placeholders
+            int line, col;
+        };
+        struct Step {
+            bool has_glyph, is_space;
+            Glyph glyph;
+        };
+        // Settings, picked up by set_text
+        float box_width = 0.0f, advance = 8.0f;
+        bool word_wrap = true;
+        const SpriteCharMap* char_map = nullptr;
+        int frame_count = 0;
+        // Cursor; carries over between texts until cleared
+        int px = 0, py = 0;
+
+        void clear();
+        void set_text(const String& new_text);
+        bool is_done() const;
+        bool step(Step& s);
+        int get_last_col(int line) const;
+    private:
+        String text = String();
+        int pos = 0;
+        std::vector<int> next_space, next_newline, last_col;
     };
 
     /*******************************************************************************
@@ -50,6 +119,10 @@ namespace godot {
 
     ReferenceRect node that writes and displays text. It creates a child ReferenceRect
     "scroll" object that SpriteFont characters are then added and positioned to.
+    In batch mode no SpriteFont nodes are made; every glyph is drawn as a region of
+    the font texture on one canvas item hung off the scroll node.
+    In console mode lines go into a fixed size ring buffer and only the lines that
+    fit in the box are laid out, reusing the glyphs from the last redraw.
 
     *******************************************************************************/
 #define MAX_CHARS 1024
@@ -65,6 +138,7 @@ namespace godot {
         // Font
         String font_path = String();
         Ref<PackedScene> font_res = nullptr;
+        const SpriteFontMetrics* font_metrics = nullptr;
         Vector2 font_scale = Vector2(1.0f, 1.0f), font_size = Vector2(8.0f, 8.0f);
         Color font_color = Color(1.0f, 1.0f, 1.0f, 1.0f);
         String font_shader = String();
@@ -77,9 +151,23 @@ namespace godot {
         bool word_wrap = true, auto_scroll = true;
         Vector2 text_margin = Vector2(0.0f, 2.0f);
         // Writing Handler
-        int write_progress = 0, next_word_length = 0;
+        SpriteTextLayout layout;
+        bool write_finished = true;
         float write_ct = 0.0f;
-        Vector2 write_pos = Vector2();
+        // Glyphs, in the same order as the scroll node's children in node mode
+        struct Glyph {
+            int line, col, frame;
+            Color color;
+        };
+        std::vector<Glyph> glyphs;
+        int align_from = -1;
+        // Batch Drawing
+        bool batch_mode = false, glyphs_dirty = false;
+        RID glyph_canvas;
+        // Console Mode
+        bool console_mode = false, console_dirty = false;
+        int console_capacity = 256, console_head = 0, console_count = 0;
+        std::vector<String> console_lines;
 
         SpriteText();
         ~SpriteText();
@@ -100,6 +188,9 @@ namespace godot {
         void set_text_margin(Vector2 new_margin); Vector2 get_text_margin();
         void set_auto_scroll(bool is_auto_scroll); bool get_auto_scroll();
         void set_scroll_speed(float new_scroll_speed); float get_scroll_speed();
+        void set_batch_mode(bool is_batch_mode); bool get_batch_mode();
+        void set_console_mode(bool is_console_mode); bool get_console_mode();
+        void set_console_capacity(int new_capacity); int get_console_capacity();
 
         // METHODS
         void add_scroll_box();
@@ -107,7 +198,17 @@ namespace godot {
         void clear();
         void write(String new_text, bool clear_text = true);
         void write_loop(float delta);
-        void write_char(int i);
+        bool write_step();
+        void add_glyph(const SpriteTextLayout::Glyph& g);
+        float get_line_offset(int line);
+        Vector2 get_glyph_position(int idx);
+        void align_glyphs();
+        void trim_glyphs();
+        void draw_glyphs();
+        // Console
+        void console_print(String line);
+        void console_clear();
+        void console_refresh();
         // Base Processing
         void ready();
         void process(float delta);
@@ -85,6 +85,7 @@ void Actor::_register_methods()
 	register_method("pathloop", &Actor::pathloop);
 	register_method("pathpong", &Actor::pathpong);
 	register_method("_ai_routine", &Actor::_ai_routine);
+	register_method("get_ai_ray_stats", &Actor::get_ai_ray_stats);
 	// Animation
 	register_method("_enter_pvs", &Actor::_enter_pvs);
 	register_method("_exit_pvs", &Actor::_exit_pvs);
@@ -115,6 +116,7 @@ void Actor::_register_methods()
 	register_method("_ready", &Actor::_ready);
 	register_method("_process", &Actor::_process);
 	register_method("_physics_process", &Actor::_physics_process);
+	register_method("_enter_tree", &Actor::_enter_tree);
 	register_method("_exit_tree", &Actor::_exit_tree);
 	// Signals
 	register_signal<Actor>("enemy_found", "new_enemy", GODOT_VARIANT_TYPE_OBJECT);
@@ -172,32 +174,44 @@ Dictionary Actor::col_ray_area(Vector3 origin, Vector3 cast_to, int mask, Array
 }
 
 // Shape checking, useful for telefrags among other things
-Ref<PhysicsShapeQueryParameters> Actor::col_make_shape_query(Transform shape_transform, float shape_margin, int mask, Array exclude)
+// Every Actor keeps one query and reuses it; each call resets everything the checks below change
+Ref<PhysicsShapeQueryParameters> Actor::col_make_shape_query(Transform shape_transform, float shape_margin, int mask, const Array& exclude)
 {
-	Ref<PhysicsShapeQueryParameters> query = Ref<PhysicsShapeQueryParameters>(PhysicsShapeQueryParameters::_new());
-	query->set_shape_rid(col_shape->get_rid());
+	if (col_query.is_null())
+		col_query = Ref<PhysicsShapeQueryParameters>(PhysicsShapeQueryParameters::_new());
+	col_query->set_shape_rid(col_shape->get_rid());
 	shape_transform *= col_node->get_transform();
-	query->set_transform(shape_transform);
-	query->set_margin(shape_margin);
-	query->set_collision_mask(mask);
-	query->set_exclude(exclude);
-	return query;
+	col_query->set_transform(shape_transform);
+	col_query->set_margin(shape_margin);
+	col_query->set_collision_mask(mask);
+	col_query->set_collide_with_bodies(true);
+	col_query->set_collide_with_areas(false);
+	// set_exclude walks the Array into a fresh RID set on the query parameters each time, so skip it when nothing changed
+	bool same_exclude = col_query_exclude.size() == exclude.size();
+	for (int i = 0; same_exclude && i < exclude.size(); i++)
+		same_exclude = col_query_exclude[i] == exclude[i];
+	if (!same_exclude)
+	{
+		col_query->set_exclude(exclude);
+		col_query_exclude = exclude.duplicate();
+	};
+	return col_query;
 }
 
-Array Actor::col_shape_check(Transform shape_transform, float shape_margin, int mask, Array exclude)
+Array Actor::col_shape_check(Transform shape_transform, float shape_margin, int mask, const Array& exclude)
 {
 	Ref<PhysicsShapeQueryParameters> query = col_make_shape_query(shape_transform, shape_margin, mask, exclude);
 	query->set_collide_with_areas(true);
 	return space_state->intersect_shape(query);
 }
 
-Array Actor::col_shape_check_body(Transform shape_transform, float shape_margin, int mask, Array exclude)
+Array Actor::col_shape_check_body(Transform shape_transform, float shape_margin, int mask, const Array& exclude)
 {
 	Ref<PhysicsShapeQueryParameters> query = col_make_shape_query(shape_transform, shape_margin, mask, exclude);
 	return space_state->intersect_shape(query);
 }
 
-Array Actor::col_shape_check_area(Transform shape_transform, float shape_margin, int mask, Array exclude)
+Array Actor::col_shape_check_area(Transform shape_transform, float shape_margin, int mask, const Array& exclude)
 {
 	Ref<PhysicsShapeQueryParameters> query = col_make_shape_query(shape_transform, shape_margin, mask, exclude);
 	query->set_collide_with_bodies(false);
@@ -205,6 +219,25 @@ Array Actor::col_shape_check_area(Transform shape_transform, float shape_margin,
 	return space_state->intersect_shape(query);
 }
 
+// Body check that hands back colliders in a caller owned buffer; returns how many were written
+int Actor::col_shape_check_body_into(Transform shape_transform, float shape_margin, int mask, const Array& exclude, Node** out, int max_out)
+{
+	if (max_out <= 0)
+		return 0;
+	Ref<PhysicsShapeQueryParameters> query = col_make_shape_query(shape_transform, shape_margin, mask, exclude);
+	Array hits = space_state->intersect_shape(query, max_out);
+	int count = 0;
+	for (int i = 0; i < hits.size() && count < max_out; i++)
+	{
+		Node* n = cast_to<Node>(Dictionary(hits[i])["collider"]);
+		if (n == nullptr)
+			continue;
+		out[count] = n;
+		count++;
+	};
+	return count;
+}
+
 Array Actor::col_cast_motion(float shape_margin, int mask, Array exclude, Vector3 motion)
 {
 	Ref<PhysicsShapeQueryParameters> query = col_make_shape_query(get_global_transform(), shape_margin, mask, exclude);
@@ -322,7 +355,7 @@ void Actor::nav_xform(float delta)
 void Actor::nav_grav_accel(float delta)
 {
 	Vector3 prev_grav_vec = grav_vector;
-	if (on_floor == false && grabbed_by.is_empty())
+	if (on_floor == false && grabbed_by.is_null())
 	{
 		//if (grav_vector.length() > max_fall_speed)
 		//	grav_vector = grav_dir * max_fall_speed;
@@ -446,7 +479,7 @@ Vector3 Actor::nav_jump(Vector3 vel, float delta)
 void Actor::nav_move(float delta)
 {
 	Vector3 v = velocity;
-	if (grabbed_by.is_empty())
+	if (grabbed_by.is_null())
 	{
 		v = nav_friction(v, delta);
 		if (on_floor || water_level >= 2)
@@ -484,7 +517,7 @@ void Actor::nav_fly_move(float delta)
 	};
 	grav_vector += grav_accel;
 	Vector3 v = velocity;
-	if (grabbed_by.is_empty())
+	if (grabbed_by.is_null())
 	{
 		v = nav_friction(v, delta);
 		v = nav_accelerate(v, delta);
@@ -527,6 +560,54 @@ bool Actor::nav_check_bottom(Vector3 offset)
 	return true;
 }
 
+Vector3 Actor::nav_ledge_dir(Vector3 dir, int n)
+{
+	if (n == 0)
+		return dir;
+	return dir.rotated(get_global_transform().basis.y, Math::deg2rad(float(n) * 45.0f));
+}
+
+// Which of the 8 directions around dir have floor under all four corners; only probes
+// the directions asked for that haven't already been answered this tick
+int Actor::nav_check_ledges(Vector3 dir, int dirs)
+{
+	int64_t frame = Engine::get_singleton()->get_physics_frames();
+	Transform t = get_global_transform();
+	if (frame != ledge_frame || dir != ledge_dir || t != ledge_xform)
+	{
+		ledge_frame = frame;
+		ledge_dir = dir;
+		ledge_xform = t;
+		ledge_known = 0;
+		ledge_safe = 0;
+	};
+	for (int n = 0; n < 8; n++)
+	{
+		int bit = 1 << n;
+		if ((dirs & bit) == 0 || (ledge_known & bit))
+			continue;
+		ledge_known |= bit;
+		if (nav_check_bottom(nav_ledge_dir(dir, n)))
+			ledge_safe |= bit;
+	};
+	return ledge_safe & dirs;
+}
+
+// First safe direction, counting down from 315 degrees or up from 0; stops probing once found
+bool Actor::nav_find_ledge_dir(Vector3 dir, bool favour_high, Vector3& out)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		int n = favour_high ? 7 - i : i;
+		if (nav_check_ledges(dir, 1 << n))
+		{
+			out = nav_ledge_dir(dir, n);
+			return true;
+		};
+	};
+	return false;
+}
+
 bool Actor::nav_check_move(Vector3 offset)
 {
 	Ref<KinematicCollision> c = move_and_collide(offset, true, true, true);
@@ -558,11 +639,11 @@ void Actor::teleport(Transform dest_xform)
 	// Telefrag
 	if (health > 0)
 	{
-		Array tfrag = col_shape_check_body(dest_xform, 0.05f, GameManager::ACTOR_LAYER, col_ex_self);
-		for (int i = 0; i < tfrag.size(); i++)
+		Node* tfrag[32];
+		int tfrag_count = col_shape_check_body_into(dest_xform, 0.05f, GameManager::ACTOR_LAYER, col_ex_self, tfrag, 32);
+		for (int i = 0; i < tfrag_count; i++)
 		{
-			Dictionary c = tfrag[i];
-			Spatial* a = cast_to<Spatial>(c["collider"]);
+			Node* a = tfrag[i];
 			if (a->has_method("damage"))
 			{
 				if ((!is_in_group("PLAYER") && a->is_in_group("PLAYER")))// || a->is_in_group("ELDERGOD"))
@@ -724,19 +805,11 @@ Array Actor::get_chase_trail()
 	return chase_trail;
 }
 
-bool Actor::check_actor_status(NodePath ent_path)
+bool Actor::check_actor_status(ActorHandle ent)
 {
-	if (ent_path.is_empty())
-		return false;
-	if (has_node(ent_path))
-	{
-		Node* ent = get_node(ent_path);
-		if (ent->is_in_group("ACTOR"))
-		{
-			if (int(ent->call("get_health")) > 0)
-				return true;
-		};
-	};
+	Actor* a = AREG->resolve(ent);
+	if (a != nullptr && a->health > 0)
+		return true;
 	return false;
 }
 
@@ -930,26 +1003,35 @@ bool Actor::is_gibbed() { return gibbed; }
 
 void Actor::set_grabbed_by(NodePath g)
 {
-	if (!has_node(g) || g == get_path())
-		g = NodePath();
-	grabbed_by = g;
+	grabbed_by = ActorHandle();
+	if (g.is_empty() || !has_node(g))
+		return;
+	Actor* a = cast_to<Actor>(get_node(g));
+	if (a != nullptr && a != this)
+		grabbed_by = a->handle;
 }
 
 NodePath Actor::get_grabbed_by()
 {
-	if (!has_node(grabbed_by))
-		grabbed_by = NodePath();
-	return grabbed_by;
+	Actor* a = AREG->resolve(grabbed_by);
+	if (a == nullptr)
+	{
+		grabbed_by = ActorHandle();
+		return NodePath();
+	};
+	return a->get_path();
 }
 
 bool Actor::check_grabbed()
 {
-	if (grabbed_by == get_path())
-		grabbed_by = NodePath();
+	if (grabbed_by == handle)
+	{
+		grabbed_by = ActorHandle();
 		return false;
+	};
 	if (check_actor_status(grabbed_by))
 		return true;
-	grabbed_by = NodePath();
+	grabbed_by = ActorHandle();
 	return false;
 }
 
@@ -966,48 +1048,17 @@ void Actor::drop_armorshards(int amount)
 // MONSTER AI -----------------------------------
 int Actor::build_enemy_list(int max_ents, float dist)
 {
-	if (actorflags &= GameManager::FL_PLAYER)
+	if (actorflags & GameManager::FL_PLAYER)
 		return 0;
-	SceneTree* tree = get_tree();
-	Array nodes_in_group;
-	Vector3 o = get_global_translation();
-	dist *= dist;
-	// Distances should not be squared!
-	// We compare each component directly rather than measure the vector to vector length.
-	//Vector3 omin = get_global_translation() - Vector3::ONE * dist;
-	//Vector3 omax = get_global_translation() + Vector3::ONE * dist;
-
 	if (max_ents > 100)
 		max_ents = 100;
-	int count = 0;
-
-	
+	// Everyone shares one spatial hash, rebuilt once per tick; we only look at the cells within range
+	ActorGrid* grid = ActorGrid::get_singleton();
+	uint32_t groups = 0;
 	for (int i = 0; i < enemy_groups.size(); i++)
-	{
-		nodes_in_group = tree->get_nodes_in_group(enemy_groups[i]);
-		for (int j = 0; j < nodes_in_group.size(); j++)
-		{
-			Spatial* e = nodes_in_group[j];
-			// Not allowed
-			int e_flags = int(e->call("get_spawnflags"));
-			if (e_flags & (GameManager::FL_DEAD | GameManager::FL_GIB))
-				continue;
-
-			// Out of range
-			/*Vector3 e_pos = e->get_global_translation();
-			if (e_pos.x < omin.x || e_pos.x > omax.x ||
-				e_pos.y < omin.y || e_pos.y > omax.y ||
-				e_pos.z < omin.z || e_pos.z > omax.z)*/
-			if (e->get_global_translation().distance_squared_to(o) > dist)
-				continue;
-			
-			enemies[count] = e;
-			count++;
-			if (count >= max_ents)
-				return count;
-		};
-	};
-	return count;
+		groups |= grid->group_mask(enemy_groups[i]);
+	grid->refresh(get_tree());
+	return grid->query(get_global_translation(), dist, groups, GameManager::FL_DEAD | GameManager::FL_GIB, enemies, max_ents);
 }
 
 bool Actor::sort_by_distance(Variant a, Variant b)
@@ -1030,8 +1081,9 @@ void Actor::_heard_player(Vector3 pos)
 
 bool Actor::check_enemy_status()
 {
-	if (enemy != nullptr && !enemy->is_queued_for_deletion() && GAME->get_notarget() == false)
-		if (int(enemy->call("get_health")) > 0)
+	Actor* e = AREG->resolve(enemy_handle);
+	if (e != nullptr && !e->is_queued_for_deletion() && GAME->get_notarget() == false)
+		if (e->health > 0)
 			return true;
 	return false;
 }
@@ -1039,7 +1091,10 @@ bool Actor::check_enemy_status()
 void Actor::clear_enemy()
 {
 	enemy = nullptr;
-	enemy_path = NodePath();
+	enemy_handle = ActorHandle();
+	AiRayBatch::get_singleton()->release(enemy_los_ticket);
+	enemy_los_ticket = -1;
+	enemy_los_clear = false;
 }
 
 void Actor::set_aim_queued(bool q) { aim_queued = q; }
@@ -1096,13 +1151,21 @@ void Actor::_enemy_found(Spatial* new_enemy)
 {
 	if (new_enemy == nullptr || (GAME->get_notarget() && new_enemy->is_in_group("PLAYER")))
 	{
-		enemy = nullptr;
-		enemy_path = NodePath();
+		clear_enemy();
 		return;
 	};
-	if (new_enemy->is_in_group("ACTOR"))
+	Actor* a = cast_to<Actor>(new_enemy);
+	if (a != nullptr && new_enemy->is_in_group("ACTOR"))
 	{
-		enemy_path = new_enemy->get_path();
+		// A ray still in flight was cast at the old enemy; the new one counts as seen, since that's
+		// how it was found, until the batch says otherwise
+		if (enemy != new_enemy)
+		{
+			AiRayBatch::get_singleton()->release(enemy_los_ticket);
+			enemy_los_ticket = -1;
+			enemy_los_clear = true;
+		};
+		enemy_handle = a->handle;
 		enemy = new_enemy;
 		last_enemy_pos = enemy->get_global_translation();
 		mad = true;
@@ -1140,6 +1203,22 @@ Vector3 Actor::lazy_aim(Vector3 pos)
 	return to_global(pos);
 }
 
+// Line of sight to the enemy comes back from the Ai ray batch a physics tick or more late;
+// until it does, the last answer stands
+bool Actor::enemy_los(Vector3 e_pos)
+{
+	AiRayBatch* rays = AiRayBatch::get_singleton();
+	AiRayBatch::Result r;
+	if (rays->get_result(enemy_los_ticket, r))
+	{
+		enemy_los_clear = !r.hit;
+		enemy_los_ticket = -1;
+	};
+	if (!rays->is_pending(enemy_los_ticket))
+		enemy_los_ticket = rays->submit(get_global_translation(), e_pos, GameManager::MAP_LAYER + GameManager::VIS_LAYER, col_ex_self);
+	return enemy_los_clear;
+}
+
 // Cycle through the target's chase trail positions; tests if there is any map
 // geometry blocking the Actor's line of sight to their target or chase trail
 // Used for AI navigation, best paired with "last_enemy_pos"
@@ -1151,7 +1230,7 @@ Vector3 Actor::chase_check(float fov)
 		Vector3 e_pos = enemy->get_global_translation();
 		if (fov > 0.0f)
 			in_fov = line_of_sight(e_pos, fov);
-		if (in_fov && col_ray(get_global_translation(), e_pos, GameManager::MAP_LAYER + GameManager::VIS_LAYER, col_ex_self).empty())
+		if (in_fov && enemy_los(e_pos))
 			return e_pos;
 		Array trail = enemy->call("get_chase_trail");
 		for (int i = 0; i < trail.size(); i++)
@@ -1192,33 +1271,14 @@ void Actor::chase_enemy_walk(float delta, float fov, float turn_speed, bool igno
 		};
 	};
 	// Don't walk off ledges; rely on triggers or custom Actor code to do so
-	if (!ignore_floor && !stationary && !nav_check_bottom(v))
+	if (!ignore_floor && !stationary && nav_check_ledges(v, 1) == 0)
 	{
 		velocity = grav_vector;
 		Vector3 v2;
-		if (rng->randi() % 2 == 0)
+		if (nav_find_ledge_dir(v, rng->randi() % 2 == 0, v2))
 		{
-			for (float ang = 0.0f; ang <= 315.0f; ang += 45.0f)
-			{
-				v2 = v.rotated(t.basis.y, Math::deg2rad(ang));
-				if (nav_check_bottom(v2))
-				{
-					hunt_time = 0.5f;
-					new_enemy_pos = v2.normalized() * (col_radius * 30.0f);
-				};
-			};
-		}
-		else
-		{
-			for (float ang = 315.0f; ang >= 0.0f; ang -= 45.0f)
-			{
-				v2 = v.rotated(t.basis.y, Math::deg2rad(ang));
-				if (nav_check_bottom(v2))
-				{
-					hunt_time = 0.5f;
-					new_enemy_pos = v2.normalized() * (col_radius * 30.0f);
-				};
-			};
+			hunt_time = 0.5f;
+			new_enemy_pos = v2.normalized() * (col_radius * 30.0f);
 		};
 	};
 	// We found our enemy
@@ -1234,6 +1294,8 @@ void Actor::chase_enemy_walk(float delta, float fov, float turn_speed, bool igno
 		move_input.z = 0.0f;
 }
 
+Dictionary Actor::get_ai_ray_stats() { return AiRayBatch::get_singleton()->get_stats(); }
+
 // Pathing
 void Actor::pathonce()
 {
@@ -1269,34 +1331,16 @@ void Actor::_ai_routine(int flags)
 	{
 	case GameManager::AI_NOPASS: // NO_PASS
 	{
-		Transform t = get_global_transform();
+		// Same turn-away as chase_enemy_walk at a ledge
 		Vector3 v = velocity;
 		velocity = grav_vector;
-		if (rng->randi() % 2 == 0)
+		if (nav_find_ledge_dir(v, rng->randi() % 2 == 0, v))
 		{
-			for (float ang = 0.0f; ang <= 315.0f; ang += 45.0f)
-			{
-				v = v.rotated(t.basis.y, Math::deg2rad(ang));
-				if (nav_check_bottom(v))
-				{
-					hunt_time = 0.5f;
-					last_enemy_pos = v.normalized() * (col_radius * 30.0f);
-				};
-			};
-		}
-		else
-		{
-			for (float ang = 315.0f; ang >= 0.0f; ang -= 45.0f)
-			{
-				v = v.rotated(t.basis.y, Math::deg2rad(ang));
-				if (nav_check_bottom(v))
-				{
-					hunt_time = 0.5f;
-					last_enemy_pos = v.normalized() * (col_radius * 30.0f);
-				};
-			};
+			hunt_time = 0.5f;
+			last_enemy_pos = v.normalized() * (col_radius * 30.0f);
 		};
 		turn_towards_pos(10.0f, last_enemy_pos);
+		return;
 	}
 	case GameManager::AI_GIB:
 		scripted_gib();
@@ -1407,60 +1451,92 @@ void Actor::set_think(String th, float n_th)
 	think = th;
 	next_think = GAME->get_time() + n_th;
 	think_check = true;
+	think_schedule();
+}
+
+// Resolve the think once up front, then let the Think Wheel wake us when it's due
+void Actor::think_schedule()
+{
+	if (think == "gib")
+		think_type = TH_GIB;
+	else if (has_method(think))
+		think_type = TH_CALL;
+	else if (think == "start")
+		think_type = TH_START;
+	else
+		think_type = TH_NONE;
+	if (think_check)
+		ThinkWheel::get_singleton()->schedule(this, next_think);
+	else
+		think_cancel();
 }
 
+void Actor::think_cancel() { ThinkWheel::get_singleton()->cancel(this); }
+
 void Actor::call_think()
 {
 	if (think_check == true && GAME->get_time() > next_think)
 	{
 		think_check = false;
-		if (think == "gib")
+		switch (think_type)
+		{
+		case TH_GIB:
 			scripted_gib();
-		else if (has_method(think))
+			return;
+		case TH_CALL:
 			call(think);
-		else if (think == "start")
+			return;
+		case TH_START:
+			think_start();
+			return;
+		};
+	}
+	// Woken a hair early; go back in the queue
+	else if (think_check == true)
+		ThinkWheel::get_singleton()->schedule(this, next_think);
+}
+
+void Actor::think_start()
+{
+	if (spawnflags > 0)
+	{
+		if (spawnflags & GameManager::FL_GIB)
+		{
+			if (properties.has("spawnvar"))
+				state_timer = properties["spawnvar"];
+			else
+				state_timer = 0.0f;
+			state_change(ST_GIBSTART);
+			return;
+		};
+		if (spawnflags & GameManager::FL_DEAD)
 		{
-			if (spawnflags > 0)
+			if (properties.has("spawnvar"))
+				state_timer = properties["spawnvar"];
+			else
+				state_timer = -1.0f;
+			state_change(ST_DEADSTART);
+			return;
+		};
+		stationary = (spawnflags & GameManager::FL_STATIONARY);
+		if (spawnflags & GameManager::FL_TELESPAWN)
+			state_change(ST_TELESPAWN);
+		if (spawnflags & GameManager::FL_AMBUSH)
+			state_change(ST_AMBUSH);
+		else if (spawnflags & GameManager::FL_PATHING)
+		{
+			stationary = false;
+			if (properties.has("spawnvar"))
 			{
-				if (spawnflags & GameManager::FL_GIB)
-				{
-					if (properties.has("spawnvar"))
-						state_timer = properties["spawnvar"];
-					else
-						state_timer = 0.0f;
-					state_change(ST_GIBSTART);
-					return;
-				};
-				if (spawnflags & GameManager::FL_DEAD)
-				{
-					if (properties.has("spawnvar"))
-						state_timer = properties["spawnvar"];
-					else
-						state_timer = -1.0f;
-					state_change(ST_DEADSTART);
-					return;
-				};
-				stationary = (spawnflags & GameManager::FL_STATIONARY);
-				if (spawnflags & GameManager::FL_TELESPAWN)
-					state_change(ST_TELESPAWN);
-				if (spawnflags & GameManager::FL_AMBUSH)
-					state_change(ST_AMBUSH);
-				else if (spawnflags & GameManager::FL_PATHING)
-				{
-					stationary = false;
-					if (properties.has("spawnvar"))
-					{
-						path_loop_type = properties["spawnvar"];
-					}
-					else
-						path_loop_type = ONCE;
-					state_change(ST_PATHING);
-				};
-			};
-			if (current_state == ST_START)
-				state_change(ST_IDLE);
+				path_loop_type = properties["spawnvar"];
+			}
+			else
+				path_loop_type = ONCE;
+			state_change(ST_PATHING);
 		};
 	};
+	if (current_state == ST_START)
+		state_change(ST_IDLE);
 }
 
 void Actor::scripted_death()
@@ -1490,6 +1566,7 @@ void Actor::remove()
 		return;
 	current_state = ST_REMOVED;
 	think_check = false;
+	think_cancel();
 	hide();
 	sfx_silence();
 	set_collision_layer(0);
@@ -1541,10 +1618,11 @@ Dictionary Actor::data_save()
 	data["superdamage"] = superdamage;
 	data["invincibility"] = invincibility;
 	data["gibbed"] = gibbed;
-	data["grabbed_by"] = grabbed_by;
+	data["grabbed_by"] = get_grabbed_by();
 	// Monster Ai
 	data["mad"] = mad;
-	data["enemy_path"] = enemy_path;
+	Actor* e = AREG->resolve(enemy_handle);
+	data["enemy_path"] = (e != nullptr) ? e->get_path() : NodePath();
 	data["last_enemy_pos"] = last_enemy_pos;
 	data["hunt_time"] = hunt_time;
 	data["hearing_range"] = hearing_range;
@@ -1573,25 +1651,26 @@ void Actor::data_load(Dictionary data)
 	think = data["think"];
 	next_think = data["next_think"];
 	think_check = data["think_check"];
+	think_schedule();
 	// Navigation
 	set_collision_layer(data["col_layer"]);
 	set_collision_mask(data["col_mask"]);
-	set_translation(GameManager::str_to_vec3(data["origin"]));
-	set_rotation(GameManager::str_to_vec3(data["rotation"]));
-	set_scale(GameManager::str_to_vec3(data["scale"]));
-	velocity = GameManager::str_to_vec3(data["velocity"]);
-	grav_dir = GameManager::str_to_vec3(data["grav_dir"]);
-	grav_vector = GameManager::str_to_vec3(data["grav_vector"]);
+	set_translation(data_vec3(data["origin"]));
+	set_rotation(data_vec3(data["rotation"]));
+	set_scale(data_vec3(data["scale"]));
+	velocity = data_vec3(data["velocity"]);
+	grav_dir = data_vec3(data["grav_dir"]);
+	grav_vector = data_vec3(data["grav_vector"]);
 	flying = data["flying"];
-	move_input = GameManager::str_to_vec3(data["move_input"]);
+	move_input = data_vec3(data["move_input"]);
 	on_floor = data["on_floor"];
 	jumping = data["jumping"];
 	check_bottom = data["check_bottom"];
 	water_level = data["water_level"];
 	water_vol = data["water_vol"];
 	water_type = data["water_type"];
-	nav_dir = GameManager::str_to_vec3(data["nav_dir"]);
-	nav_target_pos = GameManager::str_to_vec3(data["nav_target_pos"]);
+	nav_dir = data_vec3(data["nav_dir"]);
+	nav_target_pos = data_vec3(data["nav_target_pos"]);
 	max_speed = data["max_speed"];
 	// Health
 	health_max = data["health_max"];
@@ -1605,15 +1684,22 @@ void Actor::data_load(Dictionary data)
 	superdamage = data["superdamage"];
 	invincibility = data["invincibility"];
 	gibbed = data["gibbed"];
-	grabbed_by = data["grabbed_by"];
+	set_grabbed_by(data["grabbed_by"]);
 	// Monster Ai
 	mad = data["mad"];
-	enemy_path = data["enemy_path"];
-	if (has_node(enemy_path))
+	// Handles don't survive a save, so relink the enemy through its path
+	clear_enemy();
+	NodePath enemy_path = data["enemy_path"];
+	if (!enemy_path.is_empty() && has_node(enemy_path))
 	{
-		enemy = cast_to<Spatial>(get_node(enemy_path));
+		Actor* e = cast_to<Actor>(get_node(enemy_path));
+		if (e != nullptr)
+		{
+			enemy_handle = e->handle;
+			enemy = e;
+		};
 	};
-	last_enemy_pos = GameManager::str_to_vec3(data["last_enemy_pos"]);
+	last_enemy_pos = data_vec3(data["last_enemy_pos"]);
 	hunt_time = data["hunt_time"];
 	hearing_range = data["hearing_range"];
 	path_name = data["path_name"];
@@ -1765,7 +1851,7 @@ void Actor::state_idle(float delta)
 void Actor::state_physics(float delta)
 {
 	nav_floor_update();
-	if (!grabbed_by.is_empty())
+	if (!grabbed_by.is_null())
 		check_grabbed();
 	if (current_state == ST_PATHING)
 	{
@@ -1861,6 +1947,7 @@ void Actor::_ready()
 		GAME = cast_to<GameManager>(get_node("/root/GameManager"));
 		SND = cast_to<SoundManager>(get_node("/root/SoundManager"));
 		AIM = cast_to<AiManager>(get_node("/root/AiManager"));
+		AREG = ActorRegistry::get_singleton();
 		rng = Ref<RandomNumberGenerator>(RandomNumberGenerator::_new());
 		rng->set_seed(get_name().to_int());
 		// Onready vars
@@ -1892,6 +1979,7 @@ void Actor::_ready()
 		{
 			// Target groups for trigger events
 			add_to_group("ACTOR");
+			handle = AREG->add(this);
 			if (properties.has("targetname"))
 				GAME->set_node_targetname(this, properties["targetname"]);
 			// Signal connections
@@ -1920,10 +2008,7 @@ void Actor::_process(float delta)
 {
 	if (!Engine::get_singleton()->is_editor_hint())
 	{
-		if (has_node(enemy_path))
-			enemy = cast_to<Spatial>(get_node(enemy_path));
-		else
-			enemy = nullptr;
+		enemy = AREG->resolve(enemy_handle);
 		if (state_timer > 0.0f)
 			state_timer -= delta;
 		if (queue_timer > 0.0f)
@@ -1931,18 +2016,36 @@ void Actor::_process(float delta)
 		call("state_idle", delta);
 		if (damaged > 0.0f)
 			damaged -= delta;
-		call("call_think");
+		ThinkWheel::get_singleton()->advance(GAME->get_time());
 	};
 }
 
 void Actor::_physics_process(float delta)
 {
 	if (!Engine::get_singleton()->is_editor_hint())
+	{
+		AiRayBatch::get_singleton()->flush(space_state);
 		call("state_physics",delta);
+	};
+}
+
+// _ready only runs once; an Actor that was set up there and has since left and come back
+// (reparented, or removed and added again) gets a fresh handle and its pending think back here
+void Actor::_enter_tree()
+{
+	if (!handle.is_null() || !is_in_group("ACTOR"))
+		return;
+	handle = ActorRegistry::get_singleton()->add(this);
+	if (think_check)
+		think_schedule();
 }
 
 void Actor::_exit_tree()
 {
+	think_cancel();
 	clear_enemy();
+	// Anyone still holding our handle will see it go stale from here on
+	ActorRegistry::get_singleton()->remove(handle);
+	handle = ActorHandle();
 	emit_signal("actor_removed");
 }
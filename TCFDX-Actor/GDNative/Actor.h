@@ -37,6 +37,11 @@ Node Tree Setup:
 #include "SoundManager.h"
 #include "GameManager.h"
 #include "AiManager.h"
+#include "ActorGrid.h"
+#include "AiRayBatch.h"
+#include "ThinkWheel.h"
+#include "ActorRegistry.h"
+#include "SaveData.h"
 #include "Gib.h"
 #include "PathDx.h"
 
@@ -48,9 +53,11 @@ protected:
 	// Autoload References
 	GameManager* GAME; AiManager* AIM; SoundManager* SND;
 	PhysicsDirectSpaceState* space_state;
+	ActorRegistry* AREG;
 public:
 	// PROTECTED VARIABLES ==================================================
 	String classname = "";
+	ActorHandle handle;
 	Dictionary properties;
 	int spawnflags = GameManager::FL_NOT_IN_DEATHMATCH + GameManager::FL_NOT_IN_TEAMDEATHMATCH;
 	int actorflags = GameManager::FL_MONSTER;
@@ -69,11 +76,17 @@ public:
 	bool think_check = false;
 	float state_timer = 0.0f, next_think = 0.0f, queue_timer = 0.0f;
 	String think = "";
+	// Think dispatch is resolved once in set_think; the Think Wheel tracks when it's due
+	enum THINKS { TH_NONE, TH_GIB, TH_CALL, TH_START };
+	int think_type = TH_NONE, think_slot = ThinkWheel::SLOT_NONE;
+	int64_t think_tick = 0;
 	// Collision
 	CollisionShape* col_node;
 	Ref<Shape> col_shape;
 	float col_radius = 0.5f, col_floor = 1.0f;
 	Array col_ex_self;
+	Ref<PhysicsShapeQueryParameters> col_query;
+	Array col_query_exclude;
 	// Navigation
 	Vector3 grav_dir = Vector3(0, -1, 0), grav_vector = Vector3::ZERO;
 	Vector3 velocity = Vector3::ZERO;
@@ -85,6 +98,11 @@ public:
 	Vector3 grav_accel = Vector3::ZERO;
 	Vector3 nav_dir = Vector3::ZERO, nav_target_pos = Vector3::ZERO;
 	Dictionary nav_floor;
+	// Ledge probes; bit n is the probe direction turned n * 45 degrees, cached for the tick
+	Transform ledge_xform;
+	Vector3 ledge_dir = Vector3::ZERO;
+	int64_t ledge_frame = -1;
+	int ledge_known = 0, ledge_safe = 0;
 	// Water Navigation
 	float water_acceleration = 10.0f, water_friction = 4.0f, water_jump_delay = 0.0f;
 	Area* water_vol;
@@ -98,7 +116,7 @@ public:
 	float weight = 1.0f, damaged = 0.0f, shielding = 0.0f, superdamage = 0.0f, invincibility = 0.0f;
 	int bleed_type = 0, pain_chance = -1, gib_threshold = -40;
 	bool gibbed = false;
-	NodePath grabbed_by = NodePath();
+	ActorHandle grabbed_by;
 	// Monster Ai
 	bool in_pvs = false;
 	std::vector<String> enemy_groups;
@@ -107,9 +125,11 @@ public:
 	enum PATH { ONCE, LOOP, PINGPONG };
 	std::vector<PathDx*> path_list = {};
 	int next_check = 1, path_index = 0, path_loop_type = ONCE;
-	NodePath enemy_path = NodePath("");
+	ActorHandle enemy_handle;
 	Spatial* enemy = nullptr;
 	Vector3 last_enemy_pos = Vector3::ZERO;
+	int64_t enemy_los_ticket = -1;
+	bool enemy_los_clear = false;
 	bool mad = false, stationary = false, aim_queued = false;
 	float hunt_time = 0.0f;
 	String path_name = "";
@@ -142,10 +162,11 @@ public:
 	Dictionary col_ray_body(Vector3 origin, Vector3 cast_to, int mask, Array exclude);
 	Dictionary col_ray_area(Vector3 origin, Vector3 cast_to, int mask, Array exclude);
 	// Shape checking, useful for telefrags among other things
-	Ref<PhysicsShapeQueryParameters> col_make_shape_query(Transform shape_transform, float shape_margin, int mask, Array exclude);
-	Array col_shape_check(Transform shape_transform, float shape_margin, int mask, Array exclude);
-	Array col_shape_check_body(Transform shape_transform, float shape_margin, int mask, Array exclude);
-	Array col_shape_check_area(Transform shape_transform, float shape_margin, int mask, Array exclude);
+	Ref<PhysicsShapeQueryParameters> col_make_shape_query(Transform shape_transform, float shape_margin, int mask, const Array& exclude);
+	Array col_shape_check(Transform shape_transform, float shape_margin, int mask, const Array& exclude);
+	Array col_shape_check_body(Transform shape_transform, float shape_margin, int mask, const Array& exclude);
+	Array col_shape_check_area(Transform shape_transform, float shape_margin, int mask, const Array& exclude);
+	int col_shape_check_body_into(Transform shape_transform, float shape_margin, int mask, const Array& exclude, Node** out, int max_out);
 	Array col_cast_motion(float shape_margin, int mask, Array exclude, Vector3 motion);
 	// Collision layer setting
 	float get_col_floor();
@@ -170,6 +191,9 @@ public:
 	void nav_move(float delta);
 	void nav_fly_move(float delta);
 	bool nav_check_bottom(Vector3 offset = Vector3::ZERO);
+	Vector3 nav_ledge_dir(Vector3 dir, int n);
+	int nav_check_ledges(Vector3 dir, int dirs = 0xFF);
+	bool nav_find_ledge_dir(Vector3 dir, bool favour_high, Vector3& out);
 	bool nav_check_move(Vector3 offset = Vector3::ZERO);
 	Vector3 get_move_vec();
 	void set_move_input(Vector3 new_move);
@@ -199,7 +223,7 @@ public:
 	bool line_of_sight(Vector3 tgt_pos, float fov = 0.3f);
 	void chase_add_breadcrumb(float spacing = 1.0f);
 	Array get_chase_trail();
-	bool check_actor_status(NodePath ent_path);
+	bool check_actor_status(ActorHandle ent);
 
 	// COMBAT ---------------------------------------
 	// Health Management
@@ -245,9 +269,11 @@ public:
 	float enemy_distance();
 	bool enemy_in_range(float check_dist);
 	Vector3 lazy_aim(Vector3 pos);
+	bool enemy_los(Vector3 e_pos);
 	Vector3 chase_check(float fov = -1.1f);
 	void chase_enemy_walk(float delta, float fov = -1.1f, float turn_speed = 10.0f, bool ignore_floor = false);
 	void _ai_routine(int flags);
+	Dictionary get_ai_ray_stats();
 	// Pathing
 	void pathonce();
 	void pathloop();
@@ -268,6 +294,9 @@ public:
 	// SCRIPTING ------------------------------------
 	void trigger(Node* caller);
 	void set_think(String th, float n_th);
+	void think_schedule();
+	void think_cancel();
+	void think_start();
 	void scripted_death();
 	void scripted_gib();
 	void silent_gib();
@@ -290,5 +319,6 @@ public:
 	void _ready();
 	void _process(float delta);
 	void _physics_process(float delta);
+	void _enter_tree();
 	void _exit_tree();
 };
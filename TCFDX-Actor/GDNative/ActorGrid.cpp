@@ -0,0 +1,153 @@
+/*******************************************************************************
+ACTOR GRID
+Shared uniform spatial hash of every node in the enemy groups Actors hunt for.
+The grid is rebuilt at most once per tick, then Actors query it by radius
+instead of scanning their enemy groups node by node.
+*******************************************************************************/
+#include "ActorGrid.h"
+#include "Actor.h"
+#include <algorithm>
+
+ActorGrid* ActorGrid::get_singleton()
+{
+	static ActorGrid grid;
+	return &grid;
+}
+
+void ActorGrid::set_cell_size(float new_cell_size)
+{
+	cell_size = fmaxf(new_cell_size, 1.0f);
+	physics_frame = -1;
+}
+
+float ActorGrid::get_cell_size() { return cell_size; }
+
+uint32_t ActorGrid::group_mask(const String& group)
+{
+	for (int i = 0; i < groups.size(); i++)
+		if (groups[i] == group)
+			return 1u << i;
+	if (groups.size() >= MAX_GROUPS)
+		return 0;
+	groups.push_back(group);
+	physics_frame = -1;
+	return 1u << (groups.size() - 1);
+}
+
+int64_t ActorGrid::cell_key(int x, int y, int z)
+{
+	// 21 bits per axis is plenty for any map we're going to build
+	return ((int64_t(x) & 0x1FFFFF) << 42) | ((int64_t(y) & 0x1FFFFF) << 21) | (int64_t(z) & 0x1FFFFF);
+}
+
+int ActorGrid::cell_coord(float v) { return int(floorf(v / cell_size)); }
+
+// Rebuilds once per physics tick, but also once per idle frame, since nodes freed
+// at the end of a frame would otherwise leave us holding dangling pointers
+void ActorGrid::refresh(SceneTree* tree, bool force)
+{
+	Engine* engine = Engine::get_singleton();
+	int64_t pf = engine->get_physics_frames(), idf = engine->get_idle_frames();
+	if (!force && pf == physics_frame && idf == idle_frame)
+		return;
+	physics_frame = pf;
+	idle_frame = idf;
+	entries.clear();
+	entry_of.clear();
+	for (int g = 0; g < groups.size(); g++)
+	{
+		Array nodes = tree->get_nodes_in_group(groups[g]);
+		for (int i = 0; i < nodes.size(); i++)
+		{
+			Node* n = nodes[i];
+			std::unordered_map<Node*, int>::iterator itr = entry_of.find(n);
+			if (itr != entry_of.end())
+			{
+				entries[itr->second].groups |= 1u << g;
+				continue;
+			};
+			Spatial* s = Object::cast_to<Spatial>(n);
+			if (s == nullptr || s->is_queued_for_deletion())
+				continue;
+			Entry e;
+			e.node = s;
+			e.pos = s->get_global_translation();
+			Actor* a = Object::cast_to<Actor>(n);
+			if (a != nullptr)
+				e.flags = a->spawnflags;
+			else
+				e.flags = n->has_method("get_spawnflags") ? int(n->call("get_spawnflags")) : 0;
+			e.groups = 1u << g;
+			entry_of[n] = entries.size();
+			entries.push_back(e);
+		};
+	};
+	// Bucket by cell; entries stay in one flat array sorted by cell key
+	cell_index.clear();
+	for (int i = 0; i < entries.size(); i++)
+	{
+		const Vector3& p = entries[i].pos;
+		cell_index.push_back({ cell_key(cell_coord(p.x), cell_coord(p.y), cell_coord(p.z)), i });
+	};
+	std::sort(cell_index.begin(), cell_index.end());
+	cells.clear();
+	for (int i = 0; i < cell_index.size(); i++)
+	{
+		if (i == 0 || cell_index[i].first != cell_index[i - 1].first)
+			cells[cell_index[i].first] = { i, 1 };
+		else
+			cells[cell_index[i].first].second++;
+	};
+}
+
+int ActorGrid::query(Vector3 origin, float radius, uint32_t group_bits, int exclude_flags, Spatial** out, int max_out)
+{
+	if (group_bits == 0 || max_out <= 0 || entries.empty())
+		return 0;
+	float r2 = radius * radius;
+	int x0 = cell_coord(origin.x - radius), x1 = cell_coord(origin.x + radius);
+	int y0 = cell_coord(origin.y - radius), y1 = cell_coord(origin.y + radius);
+	int z0 = cell_coord(origin.z - radius), z1 = cell_coord(origin.z + radius);
+	int count = 0;
+	// A big radius covers more cells than there are actors; just check everyone
+	int64_t cell_count = int64_t(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+	if (cell_count > int64_t(entries.size()))
+	{
+		for (int i = 0; i < entries.size(); i++)
+		{
+			const Entry& e = entries[i];
+			if ((e.groups & group_bits) == 0 || (e.flags & exclude_flags))
+				continue;
+			if (e.pos.distance_squared_to(origin) > r2)
+				continue;
+			out[count] = e.node;
+			count++;
+			if (count >= max_out)
+				return count;
+		};
+		return count;
+	};
+	for (int x = x0; x <= x1; x++)
+		for (int y = y0; y <= y1; y++)
+			for (int z = z0; z <= z1; z++)
+			{
+				std::unordered_map<int64_t, std::pair<int, int>>::iterator c = cells.find(cell_key(x, y, z));
+				if (c == cells.end())
+					continue;
+				for (int i = c->second.first; i < c->second.first + c->second.second; i++)
+				{
+					const Entry& e = entries[cell_index[i].second];
+					if ((e.groups & group_bits) == 0 || (e.flags & exclude_flags))
+						continue;
+					if (e.pos.distance_squared_to(origin) > r2)
+						continue;
+					out[count] = e.node;
+					count++;
+					if (count >= max_out)
+						return count;
+				};
+			};
+	return count;
+}
+
+const std::vector<ActorGrid::Entry>& ActorGrid::get_entries() { return entries; }
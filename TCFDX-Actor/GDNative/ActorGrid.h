@@ -0,0 +1,39 @@
+/*******************************************************************************
+ACTOR GRID
+Shared uniform spatial hash of every node in the enemy groups Actors hunt for.
+The grid is rebuilt at most once per tick, then Actors query it by radius
+instead of scanning their enemy groups node by node.
+*******************************************************************************/
+#pragma once
+#include "Common.h"
+#include <vector>
+#include <unordered_map>
+#include <SceneTree.hpp>
+#include <Spatial.hpp>
+
+class ActorGrid
+{
+public:
+	struct Entry { Spatial* node; Vector3 pos; int flags; uint32_t groups; };
+	static const int MAX_GROUPS = 32;
+
+	static ActorGrid* get_singleton();
+	void set_cell_size(float new_cell_size); float get_cell_size();
+	// Register a group name and get its bit; unknown groups trigger a rebuild
+	uint32_t group_mask(const String& group);
+	// Rebuild from the scene tree if we haven't already done so this tick
+	void refresh(SceneTree* tree, bool force = false);
+	// Fill "out" with nodes in the given groups within radius of origin; returns the count
+	int query(Vector3 origin, float radius, uint32_t groups, int exclude_flags, Spatial** out, int max_out);
+	const std::vector<Entry>& get_entries();
+private:
+	float cell_size = 16.0f;
+	int64_t physics_frame = -1, idle_frame = -1;
+	std::vector<String> groups;
+	std::vector<Entry> entries;
+	std::vector<std::pair<int64_t, int>> cell_index;
+	std::unordered_map<int64_t, std::pair<int, int>> cells;
+	std::unordered_map<Node*, int> entry_of;
+	int64_t cell_key(int x, int y, int z);
+	int cell_coord(float v);
+};
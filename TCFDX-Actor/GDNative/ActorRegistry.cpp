@@ -0,0 +1,48 @@
+/*******************************************************************************
+ACTOR REGISTRY
+Generation-counted handles for live Actors. A handle resolves straight to its
+Actor in constant time, and goes stale the moment that Actor leaves the tree,
+so Actors can hold on to each other without any NodePath lookups.
+*******************************************************************************/
+#include "ActorRegistry.h"
+
+ActorRegistry* ActorRegistry::get_singleton()
+{
+	static ActorRegistry registry;
+	return &registry;
+}
+
+ActorHandle ActorRegistry::add(Actor* actor)
+{
+	ActorHandle h;
+	if (free_slots.empty())
+	{
+		slots.push_back({ nullptr, 1 });
+		h.index = slots.size() - 1;
+	}
+	else
+	{
+		h.index = free_slots.back();
+		free_slots.pop_back();
+	};
+	slots[h.index].actor = actor;
+	h.generation = slots[h.index].generation;
+	return h;
+}
+
+void ActorRegistry::remove(ActorHandle h)
+{
+	if (resolve(h) == nullptr)
+		return;
+	// Bumping the generation invalidates every copy of this handle out there
+	slots[h.index].actor = nullptr;
+	slots[h.index].generation++;
+	free_slots.push_back(h.index);
+}
+
+Actor* ActorRegistry::resolve(ActorHandle h)
+{
+	if (h.index == 0 || h.index >= slots.size() || slots[h.index].generation != h.generation)
+		return nullptr;
+	return slots[h.index].actor;
+}
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ACTOR REGISTRY
+Generation-counted handles for live Actors. A handle resolves straight to its
+Actor in constant time, and goes stale the moment that Actor leaves the tree,
+so Actors can hold on to each other without any NodePath lookups.
+*******************************************************************************/
+#pragma once
+#include "Common.h"
+#include <vector>
+
+class Actor;
+
+struct ActorHandle
+{
+	uint32_t index = 0, generation = 0;
+	bool is_null() const { return index == 0; }
+	bool operator==(const ActorHandle& h) const { return index == h.index && generation == h.generation; }
+	bool operator!=(const ActorHandle& h) const { return !(*this == h); }
+};
+
+class ActorRegistry
+{
+public:
+	static ActorRegistry* get_singleton();
+	ActorHandle add(Actor* actor);
+	void remove(ActorHandle h);
+	// Returns nullptr for null or stale handles
+	Actor* resolve(ActorHandle h);
+private:
+	struct Slot { Actor* actor; uint32_t generation; };
+	// Slot 0 is never handed out, so a zeroed handle is always null
+	std::vector<Slot> slots = { { nullptr, 0 } };
+	std::vector<uint32_t> free_slots;
+};
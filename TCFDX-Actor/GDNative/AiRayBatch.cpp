@@ -0,0 +1,127 @@
+/*******************************************************************************
+AI RAY BATCH
+Queue of line of sight rays for Actor Ai. Actors submit rays while idling and
+read back compact results after the next physics tick resolves the whole batch
+in a single pass. Each ray gets a slot that holds its result until the Actor
+reads it or gives up on it, however many ticks that takes.
+*******************************************************************************/
+#include "AiRayBatch.h"
+
+// Tickets pack the slot's generation above its index, so a reused slot never answers an old ticket
+#define RAY_INDEX_BITS 20
+
+AiRayBatch* AiRayBatch::get_singleton()
+{
+	static AiRayBatch batch;
+	return &batch;
+}
+
+AiRayBatch::Slot* AiRayBatch::find(int64_t ticket)
+{
+	if (ticket < 0)
+		return nullptr;
+	int64_t i = ticket & ((1 << RAY_INDEX_BITS) - 1);
+	if (i >= slots.size() || slots[i].generation != (ticket >> RAY_INDEX_BITS))
+		return nullptr;
+	return &slots[i];
+}
+
+void AiRayBatch::free_slot(int64_t ticket)
+{
+	int i = int(ticket & ((1 << RAY_INDEX_BITS) - 1));
+	slots[i].generation++;
+	slots[i].ready = false;
+	free_slots.push_back(i);
+}
+
+int64_t AiRayBatch::submit(Vector3 from, Vector3 to, int mask, const Array& exclude, bool bodies, bool areas)
+{
+	int i;
+	if (!free_slots.empty())
+	{
+		i = free_slots.back();
+		free_slots.pop_back();
+	}
+	else if (slots.size() < (1 << RAY_INDEX_BITS))
+	{
+		i = int(slots.size());
+		slots.push_back(Slot());
+	}
+	else
+		return -1;
+	int64_t ticket = (slots[i].generation << RAY_INDEX_BITS) | int64_t(i);
+	pending.push_back({ ticket, from, to, mask, exclude, bodies, areas });
+	return ticket;
+}
+
+bool AiRayBatch::is_pending(int64_t ticket)
+{
+	Slot* s = find(ticket);
+	return s != nullptr && !s->ready;
+}
+
+bool AiRayBatch::get_result(int64_t ticket, Result& result)
+{
+	Slot* s = find(ticket);
+	if (s == nullptr || !s->ready)
+		return false;
+	result = s->result;
+	free_slot(ticket);
+	return true;
+}
+
+void AiRayBatch::release(int64_t ticket)
+{
+	if (find(ticket) != nullptr)
+		free_slot(ticket);
+}
+
+void AiRayBatch::flush(PhysicsDirectSpaceState* space_state)
+{
+	int64_t frame = Engine::get_singleton()->get_physics_frames();
+	if (frame == flush_frame)
+		return;
+	flush_frame = frame;
+	rays_last_tick = 0;
+	if (pending.empty())
+		return;
+	for (int i = 0; i < pending.size(); i++)
+	{
+		const Request& r = pending[i];
+		// Released before it was cast
+		Slot* s = find(r.ticket);
+		if (s == nullptr)
+			continue;
+		Dictionary c = space_state->intersect_ray(r.from, r.to, r.exclude, r.mask, r.bodies, r.areas);
+		Result& res = s->result;
+		res.hit = !c.empty();
+		if (res.hit)
+		{
+			res.position = c["position"];
+			res.normal = c["normal"];
+			res.collider_id = c["collider_id"];
+		}
+		else
+		{
+			res.position = r.to;
+			res.normal = Vector3::ZERO;
+			res.collider_id = 0;
+		};
+		s->ready = true;
+		rays_last_tick++;
+	};
+	rays_total += rays_last_tick;
+	batches_total++;
+	pending.clear();
+}
+
+Dictionary AiRayBatch::get_stats()
+{
+	Dictionary stats;
+	stats["rays_per_tick"] = rays_last_tick;
+	stats["rays_total"] = rays_total;
+	stats["batches_total"] = batches_total;
+	stats["avg_batch_size"] = (batches_total > 0) ? float(rays_total) / float(batches_total) : 0.0f;
+	stats["slots_in_use"] = int(slots.size() - free_slots.size());
+	return stats;
+}
@@ -0,0 +1,39 @@
+/*******************************************************************************
+AI RAY BATCH
+Queue of line of sight rays for Actor Ai. Actors submit rays while idling and
+read back compact results after the next physics tick resolves the whole batch
+in a single pass. Each ray gets a slot that holds its result until the Actor
+reads it or gives up on it, however many ticks that takes.
+*******************************************************************************/
+#pragma once
+#include "Common.h"
+#include <vector>
+#include <PhysicsDirectSpaceState.hpp>
+
+class AiRayBatch
+{
+public:
+	struct Result { bool hit; Vector3 position, normal; int64_t collider_id; };
+
+	static AiRayBatch* get_singleton();
+	// Returns a ticket for get_result(), or -1 if every slot is taken; exclude is shared, not copied
+	int64_t submit(Vector3 from, Vector3 to, int mask, const Array& exclude, bool bodies = true, bool areas = true);
+	bool is_pending(int64_t ticket);
+	// Reading a result frees its slot, so the ticket is spent after the first true
+	bool get_result(int64_t ticket, Result& result);
+	// Drop a ticket without reading it; a ray that hasn't been cast yet won't be
+	void release(int64_t ticket);
+	// Resolve everything queued; safe to call from every Actor, only the first call each tick does any work
+	void flush(PhysicsDirectSpaceState* space_state);
+	Dictionary get_stats();
+private:
+	struct Request { int64_t ticket; Vector3 from, to; int mask; Array exclude; bool bodies, areas; };
+	struct Slot { int64_t generation = 1; bool ready = false; Result result; };
+	std::vector<Request> pending;
+	std::vector<Slot> slots;
+	std::vector<int> free_slots;
+	int64_t flush_frame = -1;
+	int64_t rays_last_tick = 0, rays_total = 0, batches_total = 0;
+	Slot* find(int64_t ticket);
+	void free_slot(int64_t ticket);
+};
@@ -619,6 +619,7 @@ void Player::exit_map()
 	camera->set_current(false);
 	current_state = ST_REMOVED;
 	think_check = false;
+	think_cancel();
 	hide();
 	hud->hide();
 	sfx_silence();
@@ -650,7 +651,7 @@ void Player::data_load(Dictionary data)
 {
 	Actor::data_load(data);
 	cam_x_rotation = data["cam_x_rotation"];
-	camera->set_rotation(GameManager::str_to_vec3(data["camera_rotation"]));
+	camera->set_rotation(data_vec3(data["camera_rotation"]));
 	items = data["items"];
 	weapons = data["weapons"];
 	wep_id = data["wep_id"];
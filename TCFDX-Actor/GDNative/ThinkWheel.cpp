@@ -0,0 +1,144 @@
+/*******************************************************************************
+THINK WHEEL
+Hierarchical timer wheel for Actor thinks. Actors are filed under the tick their
+think is due and only those are woken; everyone else costs nothing per frame.
+- Inner wheel: 256 slots of 1/64th of a second (4 seconds)
+- Outer wheel: 64 slots of 4 seconds (~17 minutes)
+- Anything further out waits in an overflow list until the outer wheel wraps
+*******************************************************************************/
+#include "ThinkWheel.h"
+#include "Actor.h"
+
+#define INNER_BITS 8
+
+ThinkWheel* ThinkWheel::get_singleton()
+{
+	static ThinkWheel wheel;
+	return &wheel;
+}
+
+std::vector<Actor*>* ThinkWheel::slot_list(int slot)
+{
+	if (slot >= 0 && slot < INNER_SLOTS)
+		return &inner[slot];
+	if (slot >= INNER_SLOTS && slot < SLOT_OVERFLOW)
+		return &outer[slot - INNER_SLOTS];
+	if (slot == SLOT_OVERFLOW)
+		return &overflow;
+	return nullptr;
+}
+
+void ThinkWheel::insert(Actor* actor)
+{
+	// Anything already overdue goes off on the very next tick
+	int64_t due = actor->think_tick;
+	if (due <= current_tick)
+		due = current_tick + 1;
+	int64_t block = due >> INNER_BITS, cur_block = current_tick >> INNER_BITS;
+	int slot;
+	if (block == cur_block)
+		slot = int(due & (INNER_SLOTS - 1));
+	else if (block - cur_block < OUTER_SLOTS)
+		slot = INNER_SLOTS + int(block & (OUTER_SLOTS - 1));
+	else
+		slot = SLOT_OVERFLOW;
+	actor->think_slot = slot;
+	slot_list(slot)->push_back(actor);
+}
+
+void ThinkWheel::cascade(std::vector<Actor*>& slot)
+{
+	std::vector<Actor*> moving;
+	moving.swap(slot);
+	for (int i = 0; i < moving.size(); i++)
+		insert(moving[i]);
+}
+
+// Game time jumped (first frame, save loaded, long hitch); refile everyone from scratch
+void ThinkWheel::rebuild(int64_t new_tick)
+{
+	std::vector<Actor*> all;
+	for (int i = 0; i < INNER_SLOTS; i++)
+	{
+		all.insert(all.end(), inner[i].begin(), inner[i].end());
+		inner[i].clear();
+	};
+	for (int i = 0; i < OUTER_SLOTS; i++)
+	{
+		all.insert(all.end(), outer[i].begin(), outer[i].end());
+		outer[i].clear();
+	};
+	all.insert(all.end(), overflow.begin(), overflow.end());
+	overflow.clear();
+	current_tick = new_tick - 1;
+	for (int i = 0; i < all.size(); i++)
+		insert(all[i]);
+}
+
+void ThinkWheel::schedule(Actor* actor, float when)
+{
+	cancel(actor);
+	actor->think_tick = int64_t(floorf(when * TICKS_PER_SEC)) + 1;
+	insert(actor);
+}
+
+void ThinkWheel::cancel(Actor* actor)
+{
+	if (actor->think_slot == SLOT_NONE)
+		return;
+	if (actor->think_slot == SLOT_FIRING)
+	{
+		for (int i = 0; i < firing.size(); i++)
+			if (firing[i] == actor)
+				firing[i] = nullptr;
+	}
+	else
+	{
+		std::vector<Actor*>* list = slot_list(actor->think_slot);
+		for (int i = 0; i < list->size(); i++)
+			if ((*list)[i] == actor)
+			{
+				(*list)[i] = list->back();
+				list->pop_back();
+				break;
+			};
+	};
+	actor->think_slot = SLOT_NONE;
+}
+
+void ThinkWheel::advance(float now)
+{
+	int64_t frame = Engine::get_singleton()->get_idle_frames();
+	if (frame == advance_frame)
+		return;
+	advance_frame = frame;
+	int64_t target = int64_t(floorf(now * TICKS_PER_SEC));
+	if (current_tick < 0 || target < current_tick || target - current_tick > INNER_SLOTS)
+		rebuild(target);
+	while (current_tick < target)
+	{
+		current_tick++;
+		// Entering a new block; pull its thinks down from the outer wheel
+		if ((current_tick & (INNER_SLOTS - 1)) == 0)
+		{
+			int64_t block = current_tick >> INNER_BITS;
+			if ((block & (OUTER_SLOTS - 1)) == 0)
+				cascade(overflow);
+			cascade(outer[block & (OUTER_SLOTS - 1)]);
+		};
+		// Anyone cancelled mid-loop gets nulled out of the firing list
+		firing.swap(inner[current_tick & (INNER_SLOTS - 1)]);
+		for (int i = 0; i < firing.size(); i++)
+			firing[i]->think_slot = SLOT_FIRING;
+		for (int i = 0; i < firing.size(); i++)
+		{
+			Actor* a = firing[i];
+			if (a == nullptr)
+				continue;
+			a->think_slot = SLOT_NONE;
+			// Through call() so a script overriding call_think still gets it
+			a->call("call_think");
+		};
+		firing.clear();
+	};
+}
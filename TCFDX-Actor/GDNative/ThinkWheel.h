@@ -0,0 +1,34 @@
+/*******************************************************************************
+THINK WHEEL
+Hierarchical timer wheel for Actor thinks. Actors are filed under the tick their
+think is due and only those are woken; everyone else costs nothing per frame.
+- Inner wheel: 256 slots of 1/64th of a second (4 seconds)
+- Outer wheel: 64 slots of 4 seconds (~17 minutes)
+- Anything further out waits in an overflow list until the outer wheel wraps
+*******************************************************************************/
+#pragma once
+#include "Common.h"
+#include <vector>
+
+class Actor;
+
+class ThinkWheel
+{
+public:
+	static const int TICKS_PER_SEC = 64, INNER_SLOTS = 256, OUTER_SLOTS = 64;
+	enum { SLOT_NONE = -1, SLOT_FIRING = -2, SLOT_OVERFLOW = INNER_SLOTS + OUTER_SLOTS };
+
+	static ThinkWheel* get_singleton();
+	// File the Actor under the first tick after "when"; replaces any think it already had queued
+	void schedule(Actor* actor, float when);
+	void cancel(Actor* actor);
+	// Wake everyone due by "now"; safe to call from every Actor, only the first call each frame does any work
+	void advance(float now);
+private:
+	std::vector<Actor*> inner[INNER_SLOTS], outer[OUTER_SLOTS], overflow, firing;
+	int64_t current_tick = -1, advance_frame = -1;
+	void insert(Actor* actor);
+	void cascade(std::vector<Actor*>& slot);
+	void rebuild(int64_t new_tick);
+	std::vector<Actor*>* slot_list(int slot);
+};